@@ -0,0 +1,176 @@
+/*
+ File: CastCommandChannel.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CastCommandChannel.h>
+
+// Qt
+#include <QStringList>
+
+//-----------------------------------------------------------------------------
+CastCommandChannel::CastCommandChannel(QProcess *process, QObject *parent)
+: QObject(parent)
+, m_process{process}
+, m_fallback{this}
+, m_pending{0}
+{
+  connect(m_process,   SIGNAL(bytesWritten(qint64)),                this, SLOT(onBytesWritten(qint64)));
+  connect(m_process,   SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onProcessFinished()));
+  connect(&m_fallback, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onFallbackFinished()));
+  connect(&m_fallback, SIGNAL(errorOccurred(QProcess::ProcessError)), this, SLOT(onFallbackError(QProcess::ProcessError)));
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::send(const QString &command, const QString &castnowPath)
+{
+  if(command.isEmpty() || m_process->state() != QProcess::Running) return;
+
+  Command queued{command, castnowPath, QElapsedTimer()};
+  queued.timer.start();
+  m_queue.push_back(std::move(queued));
+
+  sendNext();
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::flush(const int msecs)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // the process signals can be blocked while stopping, the written commands are completed here.
+  while(!m_queue.empty() && timer.elapsed() < msecs)
+  {
+    const int left = msecs - timer.elapsed();
+
+    if(m_fallback.state() != QProcess::NotRunning)
+    {
+      m_fallback.waitForFinished(left);
+      continue;
+    }
+
+    if(m_pending == 0)
+    {
+      sendNext();
+
+      // nothing is being written nor a castnow process running, the commands can't be delivered.
+      if(m_pending == 0 && m_fallback.state() == QProcess::NotRunning) break;
+      continue;
+    }
+
+    if(m_process->bytesToWrite() > 0 && !m_process->waitForBytesWritten(left)) break;
+
+    if(m_pending > 0 && m_process->bytesToWrite() == 0)
+    {
+      m_pending = 0;
+      complete(false);
+    }
+  }
+
+  m_queue.clear();
+  m_pending = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::onBytesWritten(qint64 bytes)
+{
+  if(m_pending == 0) return;
+
+  m_pending -= bytes;
+  if(m_pending <= 0)
+  {
+    m_pending = 0;
+    complete(false);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::onFallbackFinished()
+{
+  if(!m_queue.empty()) complete(true);
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::onFallbackError(QProcess::ProcessError error)
+{
+  // a process that fails to start never finishes, its command is discarded.
+  if(error == QProcess::FailedToStart && !m_queue.empty())
+  {
+    m_queue.pop_front();
+    sendNext();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::onProcessFinished()
+{
+  // a running fallback process completes its command when it finishes.
+  if(m_fallback.state() == QProcess::NotRunning) m_queue.clear();
+
+  m_pending = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::sendNext()
+{
+  if(m_queue.empty() || m_pending > 0 || m_fallback.state() != QProcess::NotRunning) return;
+
+  if(m_process->state() != QProcess::Running)
+  {
+    m_queue.clear();
+    return;
+  }
+
+  const auto &command = m_queue.front();
+
+  const auto sequence = keySequence(command.text);
+  if(!sequence.isEmpty() && m_process->write(sequence) == sequence.size())
+  {
+    m_pending = sequence.size();
+    return;
+  }
+
+  // the castnow process connects to the running session, it takes a lot longer.
+  m_fallback.start(command.castnowPath, QStringList{"--command", command.text, "--exit"});
+}
+
+//-----------------------------------------------------------------------------
+void CastCommandChannel::complete(const bool fallback)
+{
+  const auto &command = m_queue.front();
+  emit commandSent(command.text, command.timer.nsecsElapsed() / 1.e6, fallback);
+
+  m_queue.pop_front();
+  sendNext();
+}
+
+//-----------------------------------------------------------------------------
+QByteArray CastCommandChannel::keySequence(const QString &command)
+{
+  // castnow reads the keys from its input, the arrows are the terminal escape sequences.
+  if(command == "up")    return QByteArray("\x1b[A");
+  if(command == "down")  return QByteArray("\x1b[B");
+  if(command == "right") return QByteArray("\x1b[C");
+  if(command == "left")  return QByteArray("\x1b[D");
+  if(command == "space") return QByteArray(" ");
+  if(command == "quit")  return QByteArray("q");
+  if(command == "s" || command == "m" || command == "t") return command.toLatin1();
+
+  return QByteArray();
+}
@@ -0,0 +1,132 @@
+/*
+ File: CastCommandChannel.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CASTCOMMANDCHANNEL_H_
+#define CASTCOMMANDCHANNEL_H_
+
+// Qt
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+
+// C++
+#include <deque>
+
+/** \class CastCommandChannel
+ * \brief Sends the key commands to the running castnow process writing them to its standard input,
+ * one after another and without blocking. Commands without key sequence, or sent when the input can't
+ * be written, run a castnow process with the --command option instead. Reports the time from the
+ * request of every command to its delivery.
+ *
+ */
+class CastCommandChannel
+: public QObject
+{
+    Q_OBJECT
+  public:
+    /** \brief CastCommandChannel class constructor.
+     * \param[in] process Casting process, opened for reading and writing.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit CastCommandChannel(QProcess *process, QObject *parent = nullptr);
+
+    /** \brief CastCommandChannel class virtual destructor.
+     *
+     */
+    virtual ~CastCommandChannel()
+    {};
+
+    /** \brief Queues the given command to the casting process, if running.
+     * \param[in] command castnow command text.
+     * \param[in] castnowPath castnow location, used when the command can't be written to the process input.
+     *
+     */
+    void send(const QString &command, const QString &castnowPath);
+
+    /** \brief Waits until all the queued commands have been delivered or the given time has passed, the
+     * commands not delivered are discarded.
+     * \param[in] msecs Maximum time to wait in milliseconds.
+     *
+     */
+    void flush(const int msecs);
+
+  signals:
+    void commandSent(const QString &command, const double milliseconds, const bool fallback);
+
+  private slots:
+    /** \brief Completes the command being written when all its bytes have reached the process.
+     * \param[in] bytes Bytes written.
+     *
+     */
+    void onBytesWritten(qint64 bytes);
+
+    /** \brief Completes the command sent with a castnow process.
+     *
+     */
+    void onFallbackFinished();
+
+    /** \brief Discards the command of a castnow process that couldn't be started.
+     * \param[in] error Process error.
+     *
+     */
+    void onFallbackError(QProcess::ProcessError error);
+
+    /** \brief Discards the queued commands when the casting process stops.
+     *
+     */
+    void onProcessFinished();
+
+  private:
+    /** \struct Command
+     * \brief Queued command.
+     *
+     */
+    struct Command
+    {
+        QString       text;        /** castnow command text.     */
+        QString       castnowPath; /** castnow location.         */
+        QElapsedTimer timer;       /** time since the request.   */
+    };
+
+    /** \brief Sends the first queued command if no other is being sent.
+     *
+     */
+    void sendNext();
+
+    /** \brief Reports the first queued command as sent, removes it and sends the next one.
+     * \param[in] fallback True if sent with a castnow process and false otherwise.
+     *
+     */
+    void complete(const bool fallback);
+
+    /** \brief Returns the terminal key sequence of the given command or an empty array if it has none.
+     * \param[in] command castnow command text.
+     *
+     */
+    static QByteArray keySequence(const QString &command);
+
+    QProcess            *m_process;  /** casting process.                                 */
+    QProcess             m_fallback; /** castnow process for the commands not written.     */
+    std::deque<Command>  m_queue;    /** commands to send, the first one is being sent.   */
+    qint64               m_pending;  /** bytes of the command being written, 0 if none.   */
+};
+
+#endif // CASTCOMMANDCHANNEL_H_
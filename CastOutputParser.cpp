@@ -0,0 +1,234 @@
+/*
+ File: CastOutputParser.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CastOutputParser.h>
+
+// Qt
+#include <QIODevice>
+
+// C++
+#include <cctype>
+
+namespace
+{
+  /** \struct StateToken
+   * \brief Text of a playback state in the castnow output.
+   *
+   */
+  struct StateToken
+  {
+      const char               *text;  /** state text.     */
+      CastOutputParser::State   state; /** playback state. */
+  };
+
+  constexpr StateToken STATE_TOKENS[] = { { "Idle",      CastOutputParser::State::Idle    },
+                                          { "Playing",   CastOutputParser::State::Playing },
+                                          { "Loading",   CastOutputParser::State::Loading },
+                                          { "Buffering", CastOutputParser::State::Loading } };
+
+  constexpr const char *ERROR_TOKEN = "Error:";
+
+  /** \brief Returns true if the given character is a decimal digit.
+   * \param[in] c Character.
+   *
+   */
+  inline bool isDigit(const char c)
+  { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+}
+
+//-----------------------------------------------------------------------------
+CastOutputParser::CastOutputParser(QObject *parent)
+: QObject(parent)
+, m_input   {Input::Text}
+, m_state   {State::None}
+, m_seconds {-1}
+, m_duration{-1}
+{
+  m_line.reserve(m_buffer.size());
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::parse(QIODevice &device)
+{
+  qint64 read = 0;
+  while((read = device.read(m_buffer.data(), m_buffer.size())) > 0)
+  {
+    parse(m_buffer.data(), read);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::parse(const char *data, const qint64 size)
+{
+  for(qint64 i = 0; i < size; ++i)
+  {
+    const auto c = data[i];
+
+    switch(m_input)
+    {
+      case Input::Text:
+        if(c == '\x1b')                                              m_input = Input::Escape;
+        else if(c == '\n' || c == '\r')                              endLine();
+        else if(static_cast<unsigned char>(c) >= 0x20 || c == '\t') m_line.push_back(c);
+        break;
+      case Input::Escape:
+        m_input = (c == '[') ? Input::Sequence : Input::Text;
+        break;
+      case Input::Sequence:
+        // colors are part of the line, the cursor and erase sequences redraw the status.
+        if(c >= 0x40 && c <= 0x7E)
+        {
+          m_input = Input::Text;
+          if(c != 'm') endLine();
+        }
+        break;
+    }
+  }
+
+  if(!m_line.empty()) checkState(false);
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::reset()
+{
+  m_line.clear();
+  m_input    = Input::Text;
+  m_state    = State::None;
+  m_seconds  = -1;
+  m_duration = -1;
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::endLine()
+{
+  if(m_line.empty()) return;
+
+  if(m_line.find(ERROR_TOKEN) != std::string::npos)
+  {
+    if(m_state != State::Error)
+    {
+      m_state = State::Error;
+      emit error(QString::fromStdString(m_line));
+    }
+  }
+  else
+  {
+    if(!checkState(true)) checkPosition();
+  }
+
+  m_line.clear();
+}
+
+//-----------------------------------------------------------------------------
+bool CastOutputParser::checkState(const bool finished)
+{
+  for(const auto &token: STATE_TOKENS)
+  {
+    const auto position = m_line.find(token.text);
+    if(position == std::string::npos) continue;
+
+    // the state ends the line or is followed by dots, an unfinished line could continue with other text.
+    const auto end = position + std::char_traits<char>::length(token.text);
+    const auto wordStart = (position == 0) || !std::isalnum(static_cast<unsigned char>(m_line[position - 1]));
+    const auto wordEnd   = (end == m_line.size()) ? finished : (m_line[end] == '.');
+
+    if(wordStart && wordEnd)
+    {
+      setState(token.state);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::checkPosition()
+{
+  int times[2] = { 0, 0 };
+  int found = 0;
+
+  for(std::size_t i = 0; i < m_line.size() && found < 2; ++i)
+  {
+    if(!isDigit(m_line[i]) || (i > 0 && isDigit(m_line[i - 1]))) continue;
+
+    const auto next = parseTime(i, times[found]);
+    if(next != i)
+    {
+      ++found;
+      i = next;
+    }
+  }
+
+  if(found == 2 && (times[0] != m_seconds || times[1] != m_duration))
+  {
+    m_seconds  = times[0];
+    m_duration = times[1];
+    emit position(m_seconds, m_duration);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CastOutputParser::setState(const State state)
+{
+  if(state == m_state) return;
+
+  m_state = state;
+  switch(state)
+  {
+    case State::Loading: emit loading(); break;
+    case State::Playing: emit playing(); break;
+    case State::Idle:    emit idle();    break;
+    default:                             break;
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::size_t CastOutputParser::parseTime(const std::size_t position, int &seconds) const
+{
+  auto i = position;
+  int total = 0;
+  int fields = 0;
+
+  while(true)
+  {
+    const auto start = i;
+    int number = 0;
+    while(i < m_line.size() && isDigit(m_line[i]))
+    {
+      number = number * 10 + (m_line[i] - '0');
+      ++i;
+    }
+
+    // the hours or minutes can have any number of digits, the rest of fields two.
+    if(i == start || (fields > 0 && i - start != 2)) return position;
+
+    total = total * 60 + number;
+    ++fields;
+
+    if(fields == 3 || i + 1 >= m_line.size() || m_line[i] != ':' || !isDigit(m_line[i + 1])) break;
+    ++i;
+  }
+
+  if(fields < 2) return position;
+
+  seconds = total;
+  return i;
+}
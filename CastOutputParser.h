@@ -0,0 +1,151 @@
+/*
+ File: CastOutputParser.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CASTOUTPUTPARSER_H_
+#define CASTOUTPUTPARSER_H_
+
+// Qt
+#include <QObject>
+#include <QString>
+
+// C++
+#include <array>
+#include <string>
+
+class QIODevice;
+
+/** \class CastOutputParser
+ * \brief Parses the output of the castnow process as it arrives and reports the changes of the playback.
+ * The output is split in lines by the line breaks and the terminal control sequences castnow uses to
+ * redraw its status, so the text split between two reads is joined before being checked. The playback
+ * state is also checked on the unfinished line, so a last status without line break isn't missed.
+ *
+ */
+class CastOutputParser
+: public QObject
+{
+    Q_OBJECT
+  public:
+    /** \enum State
+     * \brief Playback states.
+     *
+     */
+    enum class State: char
+    {
+      None = 0, /** no state reported yet.       */
+      Loading,  /** loading or buffering media.  */
+      Playing,  /** playing media.               */
+      Idle,     /** media finished or stopped.   */
+      Error     /** media failed to load.        */
+    };
+
+    /** \brief CastOutputParser class constructor.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit CastOutputParser(QObject *parent = nullptr);
+
+    /** \brief CastOutputParser class virtual destructor.
+     *
+     */
+    virtual ~CastOutputParser()
+    {};
+
+    /** \brief Reads and parses all the available data of the given device.
+     * \param[in] device Output of the casting process.
+     *
+     */
+    void parse(QIODevice &device);
+
+    /** \brief Parses the given output data.
+     * \param[in] data Output data.
+     * \param[in] size Size of the data in bytes.
+     *
+     */
+    void parse(const char *data, const qint64 size);
+
+    /** \brief Discards the unfinished line and the state, must be called before parsing the output of a new process.
+     *
+     */
+    void reset();
+
+    /** \brief Returns the last reported playback state.
+     *
+     */
+    State state() const
+    { return m_state; }
+
+  signals:
+    void loading();
+    void playing();
+    void position(const int seconds, const int duration);
+    void idle();
+    void error(const QString &message);
+
+  private:
+    /** \enum Input
+     * \brief States of the terminal control sequences parser.
+     *
+     */
+    enum class Input: char
+    {
+      Text = 0, /** plain text.                                      */
+      Escape,   /** after the escape character.                      */
+      Sequence  /** inside a control sequence, until its final byte. */
+    };
+
+    /** \brief Checks the current line and empties it.
+     *
+     */
+    void endLine();
+
+    /** \brief Checks the current line for a change of the playback state. Returns true if found and false otherwise.
+     * \param[in] finished True if the line has ended and false if more text can follow.
+     *
+     */
+    bool checkState(const bool finished);
+
+    /** \brief Checks the current line for the playback position.
+     *
+     */
+    void checkPosition();
+
+    /** \brief Changes the playback state and emits its signal if different from the current one.
+     * \param[in] state Playback state.
+     *
+     */
+    void setState(const State state);
+
+    /** \brief Parses a time in [h:]mm:ss format at the given position of the current line. Returns the
+     * position after the time if found and the given one otherwise.
+     * \param[in] position Position in the current line.
+     * \param[out] seconds Parsed time in seconds.
+     *
+     */
+    std::size_t parseTime(const std::size_t position, int &seconds) const;
+
+    std::array<char, 4096> m_buffer;   /** buffer for reading the process output.          */
+    std::string            m_line;     /** text of the current line, without control data. */
+    Input                  m_input;    /** control sequences parser state.                  */
+    State                  m_state;    /** last reported playback state.                    */
+    int                    m_seconds;  /** last reported playback position in seconds.      */
+    int                    m_duration; /** last reported media duration in seconds.         */
+};
+
+#endif // CASTOUTPUTPARSER_H_
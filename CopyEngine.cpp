@@ -0,0 +1,1001 @@
+/*
+ File: CopyEngine.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CopyEngine.h>
+#include <XXHash64.h>
+
+// C++
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#elif defined(__WIN64__)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+const std::size_t COPY_CHUNK_SIZE  = 16*1024*1024; // bytes per in-kernel copy call.
+const std::size_t COPY_BUFFER_SIZE = 1024*1024;    // read/write buffer size.
+const std::size_t MIN_CHUNK_SIZE   = 64*1024;      // minimum bytes per in-kernel copy call when throttled.
+const std::size_t RING_SLOTS       = 8;            // buffers of the ring when copying to several destinations.
+
+#ifdef __linux__
+const int IOPRIO_CLASS_SHIFT = 13;
+const int IOPRIO_CLASS_BE    = 2;
+const int IOPRIO_CLASS_IDLE  = 3;
+const int IOPRIO_WHO_PROCESS = 1;
+#endif
+
+#ifdef __linux__
+namespace
+{
+  /** \brief Returns true if the error means that the copy method is not available for the files
+   * and another one should be tried.
+   * \param[in] error errno value.
+   *
+   */
+  bool isUnsupportedError(const int error)
+  {
+    return error == EOPNOTSUPP || error == ENOTSUP || error == EXDEV ||
+           error == EINVAL     || error == ENOSYS  || error == ENOTTY;
+  }
+}
+#elif defined(__WIN64__)
+namespace
+{
+  /** \brief Returns the error code of the last failed system call of the calling thread.
+   *
+   */
+  std::error_code lastError()
+  {
+    return std::error_code(static_cast<int>(::GetLastError()), std::system_category());
+  }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+CopyEngine::CopyEngine()
+: m_durability{Durability::None}
+, m_ioPriority{IOPriority::Normal}
+, m_bandwidth{0}
+, m_tokens{0}
+, m_refillTime{std::chrono::steady_clock::now()}
+{
+  for(auto &count: m_filesCopied) count = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CopyEngine::setBandwidthLimit(const unsigned long long bytesPerSecond)
+{
+  std::lock_guard<std::mutex> lock(m_bucketMutex);
+
+  m_bandwidth  = bytesPerSecond;
+  m_tokens     = 0;
+  m_refillTime = std::chrono::steady_clock::now();
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::syncFileSystem(const std::filesystem::path &path, std::error_code &error)
+{
+  error.clear();
+
+#ifdef __linux__
+  const int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+  if(fd < 0 || ::syncfs(fd) != 0)
+  {
+    error = std::error_code(errno, std::system_category());
+    if(fd >= 0) ::close(fd);
+    return false;
+  }
+
+  ::close(fd);
+#elif defined(__WIN64__)
+  // the volume is opened by its name so a volume mounted on a directory is flushed too.
+  WCHAR mountPoint[MAX_PATH];
+  WCHAR volume[MAX_PATH];
+  if(!::GetVolumePathNameW(path.c_str(), mountPoint, MAX_PATH) || !::GetVolumeNameForVolumeMountPointW(mountPoint, volume, MAX_PATH))
+  {
+    error = lastError();
+    return false;
+  }
+
+  // the volume name ends with a backslash that would open its root directory instead of the volume.
+  std::wstring device{volume};
+  if(!device.empty() && device.back() == L'\\') device.pop_back();
+
+  const auto handle = ::CreateFileW(device.c_str(), GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+  if(handle == INVALID_HANDLE_VALUE)
+  {
+    if(::GetLastError() != ERROR_ACCESS_DENIED)
+    {
+      error = lastError();
+      return false;
+    }
+
+    return flushFiles(path, error);
+  }
+
+  if(!::FlushFileBuffers(handle)) error = lastError();
+  ::CloseHandle(handle);
+
+  if(error) return false;
+#else
+  error = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::canFlush()
+{
+#if defined(__linux__) || defined(__WIN64__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::physicalOffset(const std::filesystem::path &filename, unsigned long long &offset)
+{
+#ifdef __linux__
+  const int fd = ::open(filename.c_str(), O_RDONLY|O_CLOEXEC);
+  if(fd < 0) return false;
+
+  // only the first extent is needed, the rest of the file is usually close to it.
+  alignas(struct fiemap) unsigned char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+  auto map = reinterpret_cast<struct fiemap *>(buffer);
+
+  map->fm_start        = 0;
+  map->fm_length       = FIEMAP_MAX_OFFSET;
+  map->fm_flags        = 0;
+  map->fm_extent_count = 1;
+
+  const bool success = ::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0 &&
+                       !(map->fm_extents[0].fe_flags & FIEMAP_EXTENT_UNKNOWN);
+  ::close(fd);
+
+  if(success) offset = map->fm_extents[0].fe_physical;
+
+  return success;
+#else
+  return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::setThreadIOPriority(const IOPriority priority)
+{
+#ifdef __linux__
+  int value = 0;
+  switch(priority)
+  {
+    case IOPriority::Low:
+      value = (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7;
+      break;
+    case IOPriority::Idle:
+      value = (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+      break;
+    default:
+    case IOPriority::Normal:
+      return true;
+  }
+
+  // with IOPRIO_WHO_PROCESS and 0 only the calling thread is changed.
+  return ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value) == 0;
+#else
+  return priority == IOPriority::Normal;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void CopyEngine::throttle(const unsigned long long bytes)
+{
+  std::chrono::duration<double> wait{0};
+
+  {
+    std::lock_guard<std::mutex> lock(m_bucketMutex);
+
+    const double rate = m_bandwidth;
+    if(rate == 0) return;
+
+    // the bucket holds at most a second of data, the bytes are taken even if the bucket goes into
+    // debt so the threads wait in turns until the debt is paid.
+    const auto now = std::chrono::steady_clock::now();
+    m_tokens = std::min(rate, m_tokens + rate * std::chrono::duration<double>(now - m_refillTime).count());
+    m_refillTime = now;
+
+    m_tokens -= bytes;
+    if(m_tokens < 0) wait = std::chrono::duration<double>(-m_tokens / rate);
+  }
+
+  if(wait.count() > 0) std::this_thread::sleep_for(wait);
+}
+
+//-----------------------------------------------------------------------------
+std::size_t CopyEngine::chunkSize() const
+{
+  // small chunks when throttled, a chunk of the whole second limit would copy in bursts.
+  const unsigned long long rate = m_bandwidth;
+  if(rate == 0) return COPY_CHUNK_SIZE;
+
+  return std::clamp<unsigned long long>(rate / 8, MIN_CHUNK_SIZE, COPY_CHUNK_SIZE);
+}
+
+//-----------------------------------------------------------------------------
+const char *CopyEngine::methodName(const Method method)
+{
+  switch(method)
+  {
+    case Method::Reflink:       return "reflink";
+    case Method::CopyFileRange: return "copy_file_range";
+    case Method::SendFile:      return "sendfile";
+    case Method::ReadWrite:     return "read/write";
+    default:
+    case Method::Default:       return "copy_file";
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::copyFile(const std::filesystem::path &from, const std::filesystem::path &to, std::error_code &error,
+                          const Progress &progress, std::uint64_t *checksum)
+{
+  error.clear();
+
+#ifdef __linux__
+  const int in = ::open(from.c_str(), O_RDONLY|O_CLOEXEC);
+  if(in < 0)
+  {
+    error = std::error_code(errno, std::system_category());
+    return false;
+  }
+
+  struct stat inStat;
+  if(::fstat(in, &inStat) != 0 || !S_ISREG(inStat.st_mode))
+  {
+    error = std::make_error_code(std::errc::invalid_argument);
+    ::close(in);
+    return false;
+  }
+
+  const int out = ::open(to.c_str(), O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, inStat.st_mode & 07777);
+  if(out < 0)
+  {
+    error = std::error_code(errno, std::system_category());
+    ::close(in);
+    return false;
+  }
+
+  struct stat outStat;
+  ::fstat(out, &outStat);
+  const Devices devices{inStat.st_dev, outStat.st_dev};
+
+  // the data must pass through the buffer to be hashed, so verified copies don't use the in-kernel methods.
+  auto method = Method::ReadWrite;
+  if(checksum)
+  {
+    if(preallocate(out, inStat.st_size, error)) readWrite(in, out, error, progress, checksum);
+
+    std::uint64_t written = 0;
+    if(!error && ::fdatasync(out) != 0) error = std::error_code(errno, std::system_category());
+    if(!error && uncachedChecksum(to, written, error) && written != *checksum) error = std::make_error_code(std::errc::io_error);
+  }
+  else
+  {
+    method = copyContents(in, out, inStat.st_size, devices, error, progress);
+  }
+
+  if(!error && m_durability == Durability::File && ::fsync(out) != 0) error = std::error_code(errno, std::system_category());
+
+  ::close(in);
+  if(::close(out) != 0 && !error) error = std::error_code(errno, std::system_category());
+
+  if(error)
+  {
+    std::error_code ignored;
+    std::filesystem::remove(to, ignored);
+    return false;
+  }
+
+  ++m_filesCopied[static_cast<int>(method)];
+  return true;
+#elif defined(__WIN64__)
+  const auto in = ::CreateFileW(from.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(in == INVALID_HANDLE_VALUE)
+  {
+    error = lastError();
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if(!::GetFileSizeEx(in, &size))
+  {
+    error = lastError();
+    ::CloseHandle(in);
+    return false;
+  }
+
+  const auto out = ::CreateFileW(to.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(out == INVALID_HANDLE_VALUE)
+  {
+    error = lastError();
+    ::CloseHandle(in);
+    return false;
+  }
+
+  if(preallocate(out, size.QuadPart, error)) readWrite(in, out, error, progress, checksum);
+
+  // verified copies are flushed to be read back from the disk.
+  if(!error && (checksum || m_durability == Durability::File) && !::FlushFileBuffers(out)) error = lastError();
+
+  ::CloseHandle(in);
+  if(!::CloseHandle(out) && !error) error = lastError();
+
+  // the destination must be closed to be read back, it's opened without sharing.
+  std::uint64_t written = 0;
+  if(!error && checksum && uncachedChecksum(to, written, error) && written != *checksum) error = std::make_error_code(std::errc::io_error);
+
+  if(error)
+  {
+    std::error_code ignored;
+    std::filesystem::remove(to, ignored);
+    return false;
+  }
+
+  ++m_filesCopied[static_cast<int>(Method::ReadWrite)];
+  return true;
+#else
+  // the copy can't be read back skipping the cache, a verification would only check the cached data.
+  if(checksum)
+  {
+    error = std::make_error_code(std::errc::operation_not_supported);
+    return false;
+  }
+
+  std::ifstream input(from, std::ios::binary);
+  if(!input)
+  {
+    error = std::make_error_code(std::errc::no_such_file_or_directory);
+    return false;
+  }
+
+  if(std::filesystem::exists(to, error) || error)
+  {
+    if(!error) error = std::make_error_code(std::errc::file_exists);
+    return false;
+  }
+
+  std::ofstream output(to, std::ios::binary|std::ios::trunc);
+  if(!output)
+  {
+    error = std::make_error_code(std::errc::permission_denied);
+    return false;
+  }
+
+  std::vector<char> buffer(std::min(COPY_BUFFER_SIZE, chunkSize()));
+  while(input && output)
+  {
+    input.read(buffer.data(), buffer.size());
+    const auto bytes = input.gcount();
+    if(bytes == 0) break;
+
+    output.write(buffer.data(), bytes);
+
+    throttle(bytes);
+    if(progress) progress(bytes);
+  }
+
+  output.close();
+  if(input.bad() || output.fail()) error = std::make_error_code(std::errc::io_error);
+
+  if(error)
+  {
+    std::error_code ignored;
+    std::filesystem::remove(to, ignored);
+    return false;
+  }
+
+  ++m_filesCopied[static_cast<int>(Method::ReadWrite)];
+  return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::copyFile(const std::filesystem::path &from, const std::vector<std::filesystem::path> &to, std::error_code &error,
+                          const Progress &progress, std::uint64_t *checksum)
+{
+  if(to.size() == 1) return copyFile(from, to.front(), error, progress, checksum);
+
+  error.clear();
+  if(to.empty()) return true;
+
+#ifdef __linux__
+  const int in = ::open(from.c_str(), O_RDONLY|O_CLOEXEC);
+  if(in < 0)
+  {
+    error = std::error_code(errno, std::system_category());
+    return false;
+  }
+
+  struct stat inStat;
+  if(::fstat(in, &inStat) != 0 || !S_ISREG(inStat.st_mode))
+  {
+    error = std::make_error_code(std::errc::invalid_argument);
+    ::close(in);
+    return false;
+  }
+
+  ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  std::vector<int> outs;
+  for(const auto &path: to)
+  {
+    const int out = ::open(path.c_str(), O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, inStat.st_mode & 07777);
+    if(out < 0)
+    {
+      error = std::error_code(errno, std::system_category());
+      break;
+    }
+
+    outs.push_back(out);
+    if(!preallocate(out, inStat.st_size, error)) break;
+  }
+
+  std::uint64_t hash = 0;
+  if(!error) fanOut(in, outs, error, progress, checksum ? &hash : nullptr);
+
+  for(std::size_t i = 0; i < outs.size() && !error; ++i)
+  {
+    if(checksum)
+    {
+      std::uint64_t written = 0;
+      if(::fdatasync(outs.at(i)) != 0) error = std::error_code(errno, std::system_category());
+      else if(uncachedChecksum(to.at(i), written, error) && written != hash) error = std::make_error_code(std::errc::io_error);
+    }
+    else
+    {
+      if(m_durability == Durability::File && ::fsync(outs.at(i)) != 0) error = std::error_code(errno, std::system_category());
+    }
+  }
+
+  ::close(in);
+  for(const auto out: outs)
+  {
+    if(::close(out) != 0 && !error) error = std::error_code(errno, std::system_category());
+  }
+
+  if(error)
+  {
+    std::error_code ignored;
+    for(std::size_t i = 0; i < outs.size(); ++i) std::filesystem::remove(to.at(i), ignored);
+    return false;
+  }
+
+  if(checksum) *checksum = hash;
+
+  ++m_filesCopied[static_cast<int>(Method::ReadWrite)];
+  return true;
+#else
+  for(std::size_t i = 0; i < to.size(); ++i)
+  {
+    if(!copyFile(from, to.at(i), error, i == 0 ? progress : Progress(), checksum))
+    {
+      std::error_code ignored;
+      for(std::size_t j = 0; j < i; ++j) std::filesystem::remove(to.at(j), ignored);
+      return false;
+    }
+  }
+
+  return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::fileChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if(!file)
+  {
+    error = std::make_error_code(std::errc::no_such_file_or_directory);
+    return false;
+  }
+
+  XXHash64 hash;
+  std::vector<char> buffer(COPY_BUFFER_SIZE);
+  while(file)
+  {
+    file.read(buffer.data(), buffer.size());
+    hash.update(buffer.data(), file.gcount());
+  }
+
+  if(file.bad())
+  {
+    error = std::make_error_code(std::errc::io_error);
+    return false;
+  }
+
+  checksum = hash.digest();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::canVerify()
+{
+#if defined(__linux__) || defined(__WIN64__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+#ifdef __linux__
+//-----------------------------------------------------------------------------
+CopyEngine::Method CopyEngine::copyContents(int in, int out, unsigned long long size, const Devices &devices, std::error_code &error, const Progress &progress)
+{
+  // reflink clones the whole file or nothing.
+  if(size > 0 && !isUnsupported(devices, Method::Reflink))
+  {
+    if(::ioctl(out, FICLONE, in) == 0)
+    {
+      if(progress) progress(size);
+      return Method::Reflink;
+    }
+
+    if(!isUnsupportedError(errno))
+    {
+      error = std::error_code(errno, std::system_category());
+      return Method::Default;
+    }
+
+    setUnsupported(devices, Method::Reflink);
+  }
+
+  if(!preallocate(out, size, error)) return Method::Default;
+
+  // the in-kernel methods advance the file offsets so the next method continues where the previous
+  // one stopped if it turns out to be unsupported.
+  unsigned long long copied = 0;
+
+  if(!isUnsupported(devices, Method::CopyFileRange))
+  {
+    while(copied < size)
+    {
+      const auto bytes = ::copy_file_range(in, nullptr, out, nullptr, std::min<unsigned long long>(chunkSize(), size - copied), 0);
+      if(bytes == 0) return Method::CopyFileRange;
+      if(bytes < 0)
+      {
+        if(errno == EINTR) continue;
+        if(!isUnsupportedError(errno))
+        {
+          error = std::error_code(errno, std::system_category());
+          return Method::Default;
+        }
+
+        setUnsupported(devices, Method::CopyFileRange);
+        break;
+      }
+
+      copied += bytes;
+      throttle(bytes);
+      if(progress) progress(bytes);
+    }
+
+    if(copied >= size) return Method::CopyFileRange;
+  }
+
+  if(!isUnsupported(devices, Method::SendFile))
+  {
+    while(copied < size)
+    {
+      const auto bytes = ::sendfile(out, in, nullptr, std::min<unsigned long long>(chunkSize(), size - copied));
+      if(bytes == 0) return Method::SendFile;
+      if(bytes < 0)
+      {
+        if(errno == EINTR) continue;
+        if(!isUnsupportedError(errno))
+        {
+          error = std::error_code(errno, std::system_category());
+          return Method::Default;
+        }
+
+        setUnsupported(devices, Method::SendFile);
+        break;
+      }
+
+      copied += bytes;
+      throttle(bytes);
+      if(progress) progress(bytes);
+    }
+
+    if(copied >= size) return Method::SendFile;
+  }
+
+  return readWrite(in, out, error, progress, nullptr) ? Method::ReadWrite : Method::Default;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::readWrite(int in, int out, std::error_code &error, const Progress &progress, std::uint64_t *checksum)
+{
+  XXHash64 hash;
+  std::vector<char> buffer(std::min(COPY_BUFFER_SIZE, chunkSize()));
+  while(true)
+  {
+    const auto bytes = ::read(in, buffer.data(), buffer.size());
+    if(bytes == 0) break;
+    if(bytes < 0)
+    {
+      if(errno == EINTR) continue;
+      error = std::error_code(errno, std::system_category());
+      return false;
+    }
+
+    if(checksum) hash.update(buffer.data(), bytes);
+
+    ssize_t written = 0;
+    while(written < bytes)
+    {
+      const auto result = ::write(out, buffer.data() + written, bytes - written);
+      if(result < 0)
+      {
+        if(errno == EINTR) continue;
+        error = std::error_code(errno, std::system_category());
+        return false;
+      }
+
+      written += result;
+    }
+
+    throttle(bytes);
+    if(progress) progress(bytes);
+  }
+
+  if(checksum) *checksum = hash.digest();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::fanOut(int in, const std::vector<int> &outs, std::error_code &error, const Progress &progress, std::uint64_t *checksum)
+{
+  // a slot can be filled again when all the writers have written it.
+  struct Slot
+  {
+      std::vector<char> data;        /** chunk data.                         */
+      std::size_t       size    = 0; /** bytes of the chunk.                 */
+      std::size_t       pending = 0; /** writers that haven't written it yet. */
+  };
+
+  std::vector<Slot> ring(RING_SLOTS);
+  for(auto &slot: ring) slot.data.resize(std::min(COPY_BUFFER_SIZE, chunkSize()));
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::size_t produced = 0;
+  bool finished = false;
+  bool failed = false;
+
+  auto fail = [&](const std::error_code &code)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!failed) error = code;
+    failed = true;
+    condition.notify_all();
+  };
+
+  auto writer = [&](const int out)
+  {
+    // the I/O priority is set per thread, the writers don't inherit the one of the copying thread.
+    setThreadIOPriority(m_ioPriority);
+
+    for(std::size_t next = 0; ; ++next)
+    {
+      Slot *slot = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return failed || finished || next < produced; });
+        if(failed || next >= produced) return;
+        slot = &ring.at(next % RING_SLOTS);
+      }
+
+      std::size_t written = 0;
+      while(written < slot->size)
+      {
+        const auto result = ::write(out, slot->data.data() + written, slot->size - written);
+        if(result < 0)
+        {
+          if(errno == EINTR) continue;
+          fail(std::error_code(errno, std::system_category()));
+          return;
+        }
+
+        written += result;
+      }
+
+      // the slot can be filled again as soon as it's released, its size is read before.
+      const auto size = slot->size;
+      bool released = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = (--slot->pending == 0);
+        condition.notify_all();
+      }
+
+      if(released && progress) progress(size);
+    }
+  };
+
+  std::vector<std::thread> writers;
+  for(const auto out: outs) writers.emplace_back(writer, out);
+
+  XXHash64 hash;
+  while(true)
+  {
+    Slot *slot = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&]() { return failed || ring.at(produced % RING_SLOTS).pending == 0; });
+      if(failed) break;
+      slot = &ring.at(produced % RING_SLOTS);
+    }
+
+    const auto bytes = ::read(in, slot->data.data(), slot->data.size());
+    if(bytes == 0) break;
+    if(bytes < 0)
+    {
+      if(errno == EINTR) continue;
+      fail(std::error_code(errno, std::system_category()));
+      break;
+    }
+
+    if(checksum) hash.update(slot->data.data(), bytes);
+    throttle(bytes);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slot->size    = bytes;
+    slot->pending = outs.size();
+    ++produced;
+    condition.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    condition.notify_all();
+  }
+
+  for(auto &thread: writers) thread.join();
+
+  if(failed) return false;
+
+  if(checksum) *checksum = hash.digest();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::uncachedChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error)
+{
+  const auto reader = ::open(filename.c_str(), O_RDONLY|O_CLOEXEC);
+  if(reader < 0)
+  {
+    error = std::error_code(errno, std::system_category());
+    return false;
+  }
+
+  // the written data is already on the disk, dropping its cached pages forces reading it back.
+  ::posix_fadvise(reader, 0, 0, POSIX_FADV_DONTNEED);
+  ::posix_fadvise(reader, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  XXHash64 hash;
+  std::vector<char> buffer(COPY_BUFFER_SIZE);
+  while(true)
+  {
+    const auto bytes = ::read(reader, buffer.data(), buffer.size());
+    if(bytes == 0) break;
+    if(bytes < 0)
+    {
+      if(errno == EINTR) continue;
+      error = std::error_code(errno, std::system_category());
+      ::close(reader);
+      return false;
+    }
+
+    hash.update(buffer.data(), bytes);
+  }
+
+  // the verified data won't be read again soon, don't keep it in the cache.
+  ::posix_fadvise(reader, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(reader);
+
+  checksum = hash.digest();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::preallocate(int fd, unsigned long long size, std::error_code &error)
+{
+  if(size == 0) return true;
+
+  // the size is kept so a copy interrupted or shorter than expected doesn't leave a longer file.
+  if(::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0 && errno == ENOSPC)
+  {
+    error = std::error_code(errno, std::system_category());
+    return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::isUnsupported(const Devices &devices, const Method method)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  const auto it = m_unsupported.find(devices);
+  return it != m_unsupported.cend() && ((*it).second & (1U << static_cast<int>(method)));
+}
+
+//-----------------------------------------------------------------------------
+void CopyEngine::setUnsupported(const Devices &devices, const Method method)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_unsupported[devices] |= (1U << static_cast<int>(method));
+}
+#elif defined(__WIN64__)
+//-----------------------------------------------------------------------------
+bool CopyEngine::readWrite(void *in, void *out, std::error_code &error, const Progress &progress, std::uint64_t *checksum)
+{
+  XXHash64 hash;
+  std::vector<char> buffer(std::min(COPY_BUFFER_SIZE, chunkSize()));
+  while(true)
+  {
+    DWORD bytes = 0;
+    if(!::ReadFile(in, buffer.data(), static_cast<DWORD>(buffer.size()), &bytes, nullptr))
+    {
+      error = lastError();
+      return false;
+    }
+
+    if(bytes == 0) break;
+
+    if(checksum) hash.update(buffer.data(), bytes);
+
+    DWORD written = 0;
+    while(written < bytes)
+    {
+      DWORD result = 0;
+      if(!::WriteFile(out, buffer.data() + written, bytes - written, &result, nullptr))
+      {
+        error = lastError();
+        return false;
+      }
+
+      written += result;
+    }
+
+    throttle(bytes);
+    if(progress) progress(bytes);
+  }
+
+  if(checksum) *checksum = hash.digest();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::uncachedChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error)
+{
+  const auto reader = ::CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_NO_BUFFERING|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(reader == INVALID_HANDLE_VALUE)
+  {
+    error = lastError();
+    return false;
+  }
+
+  // unbuffered reads need a buffer aligned to the sector size, VirtualAlloc() returns page aligned memory
+  // and the buffer size is a multiple of any sector size.
+  auto buffer = static_cast<char *>(::VirtualAlloc(nullptr, COPY_BUFFER_SIZE, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE));
+  if(!buffer)
+  {
+    error = lastError();
+    ::CloseHandle(reader);
+    return false;
+  }
+
+  XXHash64 hash;
+  bool success = true;
+  while(true)
+  {
+    DWORD bytes = 0;
+    if(!::ReadFile(reader, buffer, static_cast<DWORD>(COPY_BUFFER_SIZE), &bytes, nullptr))
+    {
+      error = lastError();
+      success = false;
+      break;
+    }
+
+    if(bytes == 0) break;
+
+    hash.update(buffer, bytes);
+  }
+
+  ::VirtualFree(buffer, 0, MEM_RELEASE);
+  ::CloseHandle(reader);
+
+  if(success) checksum = hash.digest();
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::flushFiles(const std::filesystem::path &path, std::error_code &error)
+{
+  for(auto it = std::filesystem::recursive_directory_iterator(path, std::filesystem::directory_options::skip_permission_denied, error);
+      !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+  {
+    if(!(*it).is_regular_file()) continue;
+
+    const auto handle = ::CreateFileW((*it).path().c_str(), GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+      error = lastError();
+      return false;
+    }
+
+    if(!::FlushFileBuffers(handle)) error = lastError();
+    ::CloseHandle(handle);
+  }
+
+  return !error;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyEngine::preallocate(void *handle, unsigned long long size, std::error_code &error)
+{
+  if(size == 0) return true;
+
+  // the allocation size doesn't change the end of file, like FALLOC_FL_KEEP_SIZE on Linux.
+  FILE_ALLOCATION_INFO info;
+  info.AllocationSize.QuadPart = size;
+  if(!::SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info)) && ::GetLastError() == ERROR_DISK_FULL)
+  {
+    error = lastError();
+    return false;
+  }
+
+  return true;
+}
+#endif
@@ -0,0 +1,344 @@
+/*
+ File: CopyEngine.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COPYENGINE_H_
+#define COPYENGINE_H_
+
+// C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+/** \class CopyEngine
+ * \brief Copies files with the cheapest method supported by the source and destination file systems.
+ * On Linux tries, in order, a reflink clone, copy_file_range(), sendfile() and a read/write loop with a
+ * large buffer, remembering the methods that each pair of devices doesn't support. On other systems
+ * always uses a read/write loop with a large buffer. Can be used from several threads at once.
+ *
+ * When asked to verify a copy the data is hashed with XXH64 while it passes through the copy buffer,
+ * and the destination is read back from the disk, skipping the page cache, and compared. Systems that
+ * can't skip the cache don't verify copies.
+ *
+ * The bandwidth of all the copies can be limited with a token bucket, and the limit can be changed
+ * while copying. Destination files are preallocated to their final size to avoid fragmentation.
+ *
+ * A file can be copied to several destinations at once, reading it only once into a ring of buffers
+ * that are written to all the destinations concurrently, at the pace of the slowest one.
+ *
+ */
+class CopyEngine
+{
+  public:
+    /** \enum Method
+     * \brief Copy methods, from cheapest to most expensive.
+     *
+     */
+    enum class Method: char
+    {
+      Reflink = 0,   /** FICLONE clone, shares the data blocks (btrfs, xfs). */
+      CopyFileRange, /** in-kernel copy with copy_file_range().              */
+      SendFile,      /** in-kernel copy with sendfile().                     */
+      ReadWrite,     /** user space copy with a large buffer.                */
+      Default        /** std::filesystem::copy_file().                       */
+    };
+
+    static constexpr int METHODS_COUNT = 5;
+
+    /** \enum IOPriority
+     * \brief I/O scheduling priority of the copying threads.
+     *
+     */
+    enum class IOPriority: char
+    {
+      Normal = 0, /** system default.                                      */
+      Low,        /** lowest level of the best-effort class.               */
+      Idle        /** only gets disk time when no other process needs it. */
+    };
+
+    /** \enum Durability
+     * \brief When the copied data is flushed to the destination device.
+     *
+     */
+    enum class Durability: char
+    {
+      None = 0, /** left to the system.                                             */
+      File,     /** every file is flushed before being reported as copied.          */
+      End       /** the destination file system is flushed at the end of the copy. */
+    };
+
+    using Devices = std::pair<unsigned long long, unsigned long long>; /** source and destination devices. */
+    using Progress = std::function<void(unsigned long long)>;          /** receives the bytes copied since the last call. */
+
+    /** \brief CopyEngine class constructor.
+     *
+     */
+    CopyEngine();
+
+    /** \brief Copies the given file to the destination path. The destination must not exist. Returns true
+     * on success and false otherwise, leaving no partial destination file.
+     * \param[in] from Origin file path.
+     * \param[in] to Destination file path.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Called after every copied chunk with its size in bytes, can be empty.
+     * \param[out] checksum If not null the copy is verified and the XXH64 hash of the file is returned.
+     *
+     */
+    bool copyFile(const std::filesystem::path &from, const std::filesystem::path &to, std::error_code &error,
+                  const Progress &progress = Progress(), std::uint64_t *checksum = nullptr);
+
+    /** \brief Copies the given file to all the destination paths reading it once. The destinations must
+     * not exist. Returns true on success and false otherwise, leaving no partial destination files.
+     * \param[in] from Origin file path.
+     * \param[in] to Destination file paths.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Called with the size of every chunk once written to all the destinations, can be empty.
+     * \param[out] checksum If not null the copies are verified and the XXH64 hash of the file is returned.
+     *
+     */
+    bool copyFile(const std::filesystem::path &from, const std::vector<std::filesystem::path> &to, std::error_code &error,
+                  const Progress &progress = Progress(), std::uint64_t *checksum = nullptr);
+
+    /** \brief Returns the XXH64 hash of the given file. Returns true on success and false otherwise.
+     * \param[in] filename File path.
+     * \param[out] checksum File hash.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool fileChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error);
+
+    /** \brief Returns true if the copies can be verified on this system, reading the destination back
+     * from the disk and not from the system cache (Linux and Windows).
+     *
+     */
+    static bool canVerify();
+
+    /** \brief Sets the durability policy of the copied files. Must be called before copying.
+     * \param[in] durability Durability policy.
+     *
+     */
+    void setDurability(const Durability durability)
+    { m_durability = durability; }
+
+    /** \brief Returns the durability policy of the copied files.
+     *
+     */
+    Durability durability() const
+    { return m_durability; }
+
+    /** \brief Sets the I/O priority of the threads the engine starts to write to several destinations at
+     * once. Must be called before copying.
+     * \param[in] priority I/O priority.
+     *
+     */
+    void setIOPriority(const IOPriority priority)
+    { m_ioPriority = priority; }
+
+    /** \brief Returns true if the copied data can be flushed to the destination device on this system
+     * (Linux and Windows).
+     *
+     */
+    static bool canFlush();
+
+    /** \brief Flushes all the pending writes of the file system of the given path. Returns true on
+     * success and false otherwise. On Windows flushing a volume needs administrator rights, without them
+     * all the files under the given directory are flushed instead.
+     * \param[in] path Path of a file or directory of the file system.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool syncFileSystem(const std::filesystem::path &path, std::error_code &error);
+
+    /** \brief Sets the maximum number of bytes per second copied by all the threads.
+     * \param[in] bytesPerSecond Bandwidth limit, 0 to disable the limit.
+     *
+     */
+    void setBandwidthLimit(const unsigned long long bytesPerSecond);
+
+    /** \brief Returns the bandwidth limit in bytes per second, 0 if disabled.
+     *
+     */
+    unsigned long long bandwidthLimit() const
+    { return m_bandwidth; }
+
+    /** \brief Returns the physical position on the disk of the start of the given file's data. Returns
+     * true on success and false if the file system can't report it (needs FIEMAP, Linux only).
+     * \param[in] filename File path.
+     * \param[out] offset Physical offset in bytes.
+     *
+     */
+    static bool physicalOffset(const std::filesystem::path &filename, unsigned long long &offset);
+
+    /** \brief Sets the I/O priority of the calling thread. Returns true on success and false if not
+     * supported by the system.
+     * \param[in] priority I/O priority.
+     *
+     */
+    static bool setThreadIOPriority(const IOPriority priority);
+
+    /** \brief Returns the number of files copied with the given method.
+     * \param[in] method Copy method.
+     *
+     */
+    unsigned long long filesCopied(const Method method) const
+    { return m_filesCopied[static_cast<int>(method)]; }
+
+    /** \brief Returns the name of the given method.
+     * \param[in] method Copy method.
+     *
+     */
+    static const char *methodName(const Method method);
+
+  private:
+    /** \brief Waits until the given number of bytes can be copied without exceeding the bandwidth limit.
+     * \param[in] bytes Number of bytes copied.
+     *
+     */
+    void throttle(const unsigned long long bytes);
+
+    /** \brief Returns the number of bytes to copy with every in-kernel copy call.
+     *
+     */
+    std::size_t chunkSize() const;
+
+#ifdef __linux__
+    /** \brief Copies the contents of the input file descriptor to the output one. Returns the method used
+     * or Method::Default on error.
+     * \param[in] in Input file descriptor.
+     * \param[in] out Output file descriptor.
+     * \param[in] size Input file size.
+     * \param[in] devices Source and destination devices.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Copied bytes callback, can be empty.
+     *
+     */
+    Method copyContents(int in, int out, unsigned long long size, const Devices &devices, std::error_code &error, const Progress &progress);
+
+    /** \brief Copies the contents of the input file descriptor to the output one with a read/write loop.
+     * Returns true on success and false otherwise.
+     * \param[in] in Input file descriptor.
+     * \param[in] out Output file descriptor.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Copied bytes callback, can be empty.
+     * \param[out] checksum If not null, hash of the copied data.
+     *
+     */
+    bool readWrite(int in, int out, std::error_code &error, const Progress &progress, std::uint64_t *checksum);
+
+    /** \brief Reads the input file descriptor once and writes its contents to all the output ones, each
+     * written by its own thread from a shared ring of buffers. Returns true on success and false otherwise.
+     * \param[in] in Input file descriptor.
+     * \param[in] outs Output file descriptors.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Copied bytes callback, can be empty.
+     * \param[out] checksum If not null, hash of the copied data.
+     *
+     */
+    bool fanOut(int in, const std::vector<int> &outs, std::error_code &error, const Progress &progress, std::uint64_t *checksum);
+
+    /** \brief Computes the hash of the contents of the given file reading from the disk and not from the
+     * page cache. The file data must have been synchronized. Returns true on success and false otherwise.
+     * \param[in] filename File path.
+     * \param[out] checksum Hash of the file contents.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool uncachedChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error);
+
+    /** \brief Reserves the space of the given size for the file without changing its size. Returns false
+     * only if there is not enough space, the rest of errors are ignored as the file system will allocate
+     * the space while writing.
+     * \param[in] fd File descriptor.
+     * \param[in] size File size in bytes.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool preallocate(int fd, unsigned long long size, std::error_code &error);
+
+    /** \brief Returns true if the given method is known to fail for the given pair of devices.
+     * \param[in] devices Source and destination devices.
+     * \param[in] method Copy method.
+     *
+     */
+    bool isUnsupported(const Devices &devices, const Method method);
+
+    /** \brief Marks the given method as not supported for the given pair of devices.
+     * \param[in] devices Source and destination devices.
+     * \param[in] method Copy method.
+     *
+     */
+    void setUnsupported(const Devices &devices, const Method method);
+#elif defined(__WIN64__)
+    /** \brief Copies the contents of the input file handle to the output one with a read/write loop.
+     * Returns true on success and false otherwise.
+     * \param[in] in Input file handle.
+     * \param[in] out Output file handle.
+     * \param[out] error Error code in case of failure.
+     * \param[in] progress Copied bytes callback, can be empty.
+     * \param[out] checksum If not null, hash of the copied data.
+     *
+     */
+    bool readWrite(void *in, void *out, std::error_code &error, const Progress &progress, std::uint64_t *checksum);
+
+    /** \brief Computes the hash of the contents of the given file reading from the disk without buffering
+     * it in the system cache. The file data must have been flushed. Returns true on success and false otherwise.
+     * \param[in] filename File path.
+     * \param[out] checksum Hash of the file contents.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool uncachedChecksum(const std::filesystem::path &filename, std::uint64_t &checksum, std::error_code &error);
+
+    /** \brief Flushes the pending writes of all the files under the given directory. Returns true on
+     * success and false otherwise.
+     * \param[in] path Directory path.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool flushFiles(const std::filesystem::path &path, std::error_code &error);
+
+    /** \brief Reserves the space of the given size for the file without changing its size. Returns false
+     * only if there is not enough space, the rest of errors are ignored as the file system will allocate
+     * the space while writing.
+     * \param[in] handle File handle.
+     * \param[in] size File size in bytes.
+     * \param[out] error Error code in case of failure.
+     *
+     */
+    static bool preallocate(void *handle, unsigned long long size, std::error_code &error);
+#endif
+
+    std::mutex                            m_mutex;                      /** protects the unsupported methods map. */
+    std::map<Devices, unsigned>           m_unsupported;                /** unsupported methods mask per devices. */
+    std::atomic<unsigned long long>       m_filesCopied[METHODS_COUNT]; /** number of files copied per method.    */
+    Durability                            m_durability;                 /** durability policy.                    */
+    IOPriority                            m_ioPriority;                 /** I/O priority of the writer threads.   */
+    std::atomic<unsigned long long>       m_bandwidth;                  /** bandwidth limit in bytes per second.  */
+    std::mutex                            m_bucketMutex;                /** protects the token bucket.            */
+    double                                m_tokens;                     /** bytes that can be copied now.         */
+    std::chrono::steady_clock::time_point m_refillTime;                 /** last time the bucket was refilled.    */
+};
+
+#endif // COPYENGINE_H_
@@ -0,0 +1,156 @@
+/*
+ File: CopyJournal.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CopyJournal.h>
+
+// C++
+#include <sstream>
+
+const std::string CopyJournal::PART_EXTENSION = ".nowplay-part";
+
+const std::string JOURNAL_FILENAME = ".nowplay-journal";
+const std::string JOURNAL_HEADER   = "NowPlay copy journal 1";
+
+// Journal lines after the header, every one ended by a new line:
+//   S <size> <source directory>   selected directory, in selection order.
+//   C <position>                  directory in the given position completely copied.
+
+//-----------------------------------------------------------------------------
+CopyJournal::CopyJournal(const std::filesystem::path &destination)
+: m_filename{destination / JOURNAL_FILENAME}
+{
+}
+
+//-----------------------------------------------------------------------------
+bool CopyJournal::exists(const std::filesystem::path &destination)
+{
+  std::error_code error;
+  return std::filesystem::is_regular_file(destination / JOURNAL_FILENAME, error);
+}
+
+//-----------------------------------------------------------------------------
+bool CopyJournal::create(const std::vector<Utils::FileInformation> &directories)
+{
+  m_stream.close();
+  m_stream.open(m_filename, std::ios::out|std::ios::trunc);
+  if(!m_stream) return false;
+
+  m_stream << JOURNAL_HEADER << '\n';
+  for(const auto &dir: directories)
+  {
+    m_stream << "S " << dir.second << ' ' << dir.first.u8string() << '\n';
+  }
+  m_stream.flush();
+
+  m_directories = directories;
+  m_completed.assign(directories.size(), false);
+
+  return static_cast<bool>(m_stream);
+}
+
+//-----------------------------------------------------------------------------
+bool CopyJournal::add(const Utils::FileInformation &directory)
+{
+  m_stream << "S " << directory.second << ' ' << directory.first.u8string() << '\n';
+  m_stream.flush();
+
+  m_directories.push_back(directory);
+  m_completed.push_back(false);
+
+  return static_cast<bool>(m_stream);
+}
+
+//-----------------------------------------------------------------------------
+bool CopyJournal::load()
+{
+  std::ifstream input(m_filename);
+  if(!input) return false;
+
+  std::string line;
+  if(!std::getline(input, line) || line != JOURNAL_HEADER) return false;
+
+  std::vector<Utils::FileInformation> directories;
+  std::vector<bool> completed;
+
+  while(std::getline(input, line))
+  {
+    // every record ends with a new line, a last line without it was being written when interrupted.
+    if(input.eof()) break;
+
+    std::istringstream stream(line);
+    char type = 0;
+    stream >> type;
+
+    switch(type)
+    {
+      case 'S':
+        {
+          unsigned long long size = 0;
+          std::string path;
+          stream >> size;
+          stream.get();
+          std::getline(stream, path);
+          if(!stream && !stream.eof()) return false;
+
+          directories.emplace_back(std::filesystem::u8path(path), size);
+          completed.push_back(false);
+        }
+        break;
+      case 'C':
+        {
+          std::size_t position = 0;
+          if((stream >> position) && position < completed.size()) completed.at(position) = true;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if(directories.empty()) return false;
+
+  m_directories = std::move(directories);
+  m_completed   = std::move(completed);
+
+  m_stream.close();
+  m_stream.open(m_filename, std::ios::out|std::ios::app);
+
+  return static_cast<bool>(m_stream);
+}
+
+//-----------------------------------------------------------------------------
+bool CopyJournal::setCompleted(const std::size_t position)
+{
+  m_completed.at(position) = true;
+
+  m_stream << "C " << position << '\n';
+  m_stream.flush();
+
+  return static_cast<bool>(m_stream);
+}
+
+//-----------------------------------------------------------------------------
+void CopyJournal::remove()
+{
+  m_stream.close();
+
+  std::error_code error;
+  std::filesystem::remove(m_filename, error);
+}
@@ -0,0 +1,104 @@
+/*
+ File: CopyJournal.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COPYJOURNAL_H_
+#define COPYJOURNAL_H_
+
+// Project
+#include <Utils.h>
+
+// C++
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+/** \class CopyJournal
+ * \brief Record of a copy job kept in the destination directory. Stores the selected directories
+ * and the ones already copied so an interrupted copy can be resumed. Not thread-safe.
+ *
+ */
+class CopyJournal
+{
+  public:
+    static const std::string PART_EXTENSION; /** extension of the files being copied. */
+
+    /** \brief CopyJournal class constructor.
+     * \param[in] destination Destination directory of the copy.
+     *
+     */
+    explicit CopyJournal(const std::filesystem::path &destination);
+
+    /** \brief Returns true if the given destination directory has the journal of an unfinished copy.
+     * \param[in] destination Destination directory.
+     *
+     */
+    static bool exists(const std::filesystem::path &destination);
+
+    /** \brief Creates a new journal with the given selected directories, replacing any previous one.
+     * Returns true on success and false otherwise.
+     * \param[in] directories Selected directories to copy.
+     *
+     */
+    bool create(const std::vector<Utils::FileInformation> &directories);
+
+    /** \brief Adds a selected directory to the end of the journal. Returns true on success and false otherwise.
+     * \param[in] directory Selected directory to copy.
+     *
+     */
+    bool add(const Utils::FileInformation &directory);
+
+    /** \brief Loads the journal from the destination directory and opens it to record the copied
+     * directories. Returns true on success and false otherwise.
+     *
+     */
+    bool load();
+
+    /** \brief Returns the selected directories of the copy.
+     *
+     */
+    const std::vector<Utils::FileInformation> &directories() const
+    { return m_directories; }
+
+    /** \brief Returns true if the directory in the given position has been completely copied.
+     * \param[in] position Position of the directory in the selection.
+     *
+     */
+    bool isCompleted(const std::size_t position) const
+    { return m_completed.at(position); }
+
+    /** \brief Records the directory in the given position as completely copied. Returns true on success
+     * and false otherwise.
+     * \param[in] position Position of the directory in the selection.
+     *
+     */
+    bool setCompleted(const std::size_t position);
+
+    /** \brief Removes the journal from the destination directory once the copy has finished.
+     *
+     */
+    void remove();
+
+  private:
+    const std::filesystem::path         m_filename;    /** journal file path.                      */
+    std::vector<Utils::FileInformation> m_directories; /** selected directories.                   */
+    std::vector<bool>                   m_completed;   /** true for the already copied directories. */
+    std::ofstream                       m_stream;      /** journal stream opened for appending.     */
+};
+
+#endif // COPYJOURNAL_H_
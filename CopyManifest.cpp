@@ -0,0 +1,95 @@
+/*
+ File: CopyManifest.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CopyManifest.h>
+
+// C++
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+const std::string MANIFEST_FILENAME = ".nowplay-manifest";
+
+// One line per file: <hash as 16 hex digits> <size> <file name>
+
+//-----------------------------------------------------------------------------
+CopyManifest::CopyManifest(const std::filesystem::path &directory)
+: m_filename{directory / MANIFEST_FILENAME}
+{
+}
+
+//-----------------------------------------------------------------------------
+bool CopyManifest::exists(const std::filesystem::path &directory)
+{
+  std::error_code error;
+  return std::filesystem::is_regular_file(directory / MANIFEST_FILENAME, error);
+}
+
+//-----------------------------------------------------------------------------
+bool CopyManifest::load()
+{
+  std::ifstream input(m_filename);
+  if(!input) return false;
+
+  std::map<std::string, Entry> entries;
+
+  std::string line;
+  while(std::getline(input, line))
+  {
+    std::istringstream stream(line);
+    Entry entry;
+    std::string name;
+
+    stream >> std::hex >> entry.checksum >> std::dec >> entry.size;
+    stream.get();
+    std::getline(stream, name);
+
+    if(!stream.fail() && !name.empty()) entries[name] = entry;
+  }
+
+  m_entries = std::move(entries);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CopyManifest::save() const
+{
+  std::ofstream output(m_filename, std::ios::out|std::ios::trunc);
+  if(!output) return false;
+
+  char hash[17];
+  for(const auto &entry: m_entries)
+  {
+    std::snprintf(hash, sizeof(hash), "%016" PRIx64, entry.second.checksum);
+    output << hash << ' ' << entry.second.size << ' ' << entry.first << '\n';
+  }
+
+  return static_cast<bool>(output.flush());
+}
+
+//-----------------------------------------------------------------------------
+const CopyManifest::Entry *CopyManifest::find(const std::filesystem::path &filename) const
+{
+  const auto it = m_entries.find(filename.u8string());
+
+  return it == m_entries.cend() ? nullptr : &(*it).second;
+}
@@ -0,0 +1,94 @@
+/*
+ File: CopyManifest.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COPYMANIFEST_H_
+#define COPYMANIFEST_H_
+
+// C++
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+/** \class CopyManifest
+ * \brief List of the verified files of a copied directory with their size and XXH64 hash, stored
+ * in the directory next to the files. Not thread-safe.
+ *
+ */
+class CopyManifest
+{
+  public:
+    /** \struct Entry
+     * \brief Verified file information.
+     *
+     */
+    struct Entry
+    {
+        unsigned long long size;     /** file size in bytes. */
+        std::uint64_t      checksum; /** XXH64 file hash.    */
+    };
+
+    /** \brief CopyManifest class constructor. Creates an empty manifest.
+     * \param[in] directory Directory of the files.
+     *
+     */
+    explicit CopyManifest(const std::filesystem::path &directory);
+
+    /** \brief Returns true if the given directory has a manifest.
+     * \param[in] directory Directory path.
+     *
+     */
+    static bool exists(const std::filesystem::path &directory);
+
+    /** \brief Loads the manifest of the directory. Returns true on success and false otherwise.
+     *
+     */
+    bool load();
+
+    /** \brief Stores the manifest in the directory. Returns true on success and false otherwise.
+     *
+     */
+    bool save() const;
+
+    /** \brief Returns the entry of the given file or nullptr if the file is not in the manifest.
+     * \param[in] filename File name, without the directory.
+     *
+     */
+    const Entry *find(const std::filesystem::path &filename) const;
+
+    /** \brief Adds or replaces the entry of the given file.
+     * \param[in] filename File name, without the directory.
+     * \param[in] entry File information.
+     *
+     */
+    void set(const std::filesystem::path &filename, const Entry &entry)
+    { m_entries[filename.u8string()] = entry; }
+
+    /** \brief Returns true if the manifest has no files.
+     *
+     */
+    bool isEmpty() const
+    { return m_entries.empty(); }
+
+  private:
+    const std::filesystem::path  m_filename; /** manifest file path.             */
+    std::map<std::string, Entry> m_entries;  /** verified files by UTF-8 name.   */
+};
+
+#endif // COPYMANIFEST_H_
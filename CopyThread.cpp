@@ -19,61 +19,880 @@
 
 // Project
 #include <CopyThread.h>
+#include <CopyJournal.h>
+#include <CopyManifest.h>
+#include <OnlineSelection.h>
 
 // Qt
 #include <QDir>
+#include <QStringList>
 
 // C++
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+  /** \struct CopyJob
+   * \brief File to be copied by the workers.
+   *
+   */
+  struct CopyJob
+  {
+      std::filesystem::path              source;       /** origin file path.                               */
+      std::vector<std::filesystem::path> destinations; /** destination file paths.                         */
+      std::vector<std::size_t>           targets;      /** destinations positions of the destination paths. */
+      std::size_t                        directory;    /** position of the file's selected directory.      */
+  };
+
+  /** \class WorkQueue
+   * \brief Bounded queue between the pipeline stages: the scanner, the thread that lists the directories
+   * and the workers.
+   *
+   */
+  template<typename T> class WorkQueue
+  {
+    public:
+      /** \brief WorkQueue class constructor.
+       * \param[in] capacity Maximum number of queued jobs.
+       *
+       */
+      explicit WorkQueue(const std::size_t capacity)
+      : m_capacity{capacity}
+      , m_closed{false}
+      {}
+
+      /** \brief Adds a job to the queue, waits while the queue is full.
+       * \param[in] job Job.
+       *
+       */
+      void push(T job)
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]() { return m_jobs.size() < m_capacity; });
+        m_jobs.push_back(std::move(job));
+        m_notEmpty.notify_one();
+      }
+
+      /** \brief Takes a job from the queue, waits while the queue is empty and open. Returns false
+       * if the queue is closed and empty.
+       * \param[out] job Job.
+       *
+       */
+      bool pop(T &job)
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return !m_jobs.empty() || m_closed; });
+        if(m_jobs.empty()) return false;
+
+        job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        m_notFull.notify_one();
+        return true;
+      }
+
+      /** \brief Closes the queue, no more jobs will be added.
+       *
+       */
+      void close()
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+      }
+
+    private:
+      const std::size_t       m_capacity; /** maximum number of jobs.             */
+      bool                    m_closed;   /** true if no more jobs will be added. */
+      std::deque<T>           m_jobs;     /** queued jobs.                        */
+      std::mutex              m_mutex;    /** protects the queue.                 */
+      std::condition_variable m_notEmpty; /** signals new jobs or closing.        */
+      std::condition_variable m_notFull;  /** signals free space.                 */
+  };
+
+  /** \struct Transfer
+   * \brief Copied bytes and speed at a given moment.
+   *
+   */
+  struct Transfer
+  {
+      unsigned long long total       = 0;  /** bytes to copy.                                  */
+      unsigned long long bytes       = 0;  /** bytes done, copied or already in the destination. */
+      unsigned long long copied      = 0;  /** bytes copied.                                   */
+      double             rate        = 0;  /** bytes per second in the last seconds.           */
+      double             averageRate = 0;  /** bytes per second since the start.               */
+      int                secondsLeft = -1; /** estimated seconds to finish or -1 if unknown.   */
+      double             seconds     = 0;  /** seconds since the start.                        */
+  };
+
+  /** \class ThroughputMeter
+   * \brief Accumulates the bytes copied by the workers and computes the speed over a sliding window.
+   *
+   */
+  class ThroughputMeter
+  {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      /** \brief ThroughputMeter class constructor.
+       * \param[in] total Total bytes to copy.
+       *
+       */
+      explicit ThroughputMeter(const unsigned long long total)
+      : m_total{total}
+      , m_bytes{0}
+      , m_skipped{0}
+      , m_start{Clock::now()}
+      , m_lastReport{m_start}
+      { m_samples.emplace_back(m_start, 0); }
+
+      /** \brief Adds the given copied bytes. Returns true and the current state if it's time to report it.
+       * \param[in] bytes Copied bytes.
+       * \param[out] transfer Current state of the copy.
+       *
+       */
+      bool add(const unsigned long long bytes, Transfer &transfer)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bytes += bytes;
+
+        return update(transfer);
+      }
+
+      /** \brief Adds the given bytes as done without copying them, they don't count for the speed. Returns
+       * true and the current state if it's time to report it.
+       * \param[in] bytes Skipped bytes.
+       * \param[out] transfer Current state of the copy.
+       *
+       */
+      bool skip(const unsigned long long bytes, Transfer &transfer)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bytes   += bytes;
+        m_skipped += bytes;
+
+        return update(transfer);
+      }
+
+      /** \brief Changes the total bytes to copy, when not known at the start.
+       * \param[in] total Total bytes to copy.
+       *
+       */
+      void setTotal(const unsigned long long total)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_total = total;
+      }
+
+      /** \brief Returns the current state of the copy.
+       *
+       */
+      Transfer current()
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return state(Clock::now());
+      }
+
+    private:
+      /** \brief Returns true and the current state if it's time to report it. Must be called with the mutex locked.
+       * \param[out] transfer Current state of the copy.
+       *
+       */
+      bool update(Transfer &transfer)
+      {
+        const auto now = Clock::now();
+        if(now - m_lastReport < REPORT_INTERVAL) return false;
+
+        m_lastReport = now;
+        m_samples.emplace_back(now, m_bytes - m_skipped);
+        while(m_samples.size() > 2 && now - m_samples.at(1).first >= RATE_WINDOW) m_samples.pop_front();
+
+        transfer = state(now);
+        return true;
+      }
+
+      /** \brief Computes the state of the copy at the given time. Must be called with the mutex locked.
+       * \param[in] now Current time.
+       *
+       */
+      Transfer state(const Clock::time_point now) const
+      {
+        Transfer transfer;
+        transfer.total   = m_total;
+        transfer.bytes   = m_bytes;
+        transfer.copied  = m_bytes - m_skipped;
+        transfer.seconds = std::chrono::duration<double>(now - m_start).count();
+
+        if(transfer.seconds > 0) transfer.averageRate = transfer.copied / transfer.seconds;
+
+        const auto &oldest = m_samples.front();
+        const auto windowSeconds = std::chrono::duration<double>(now - oldest.first).count();
+        if(windowSeconds > 0) transfer.rate = (transfer.copied - oldest.second) / windowSeconds;
+
+        if(transfer.rate > 0) transfer.secondsLeft = (m_total > m_bytes) ? (m_total - m_bytes) / transfer.rate : 0;
+
+        return transfer;
+      }
+
+      static constexpr auto REPORT_INTERVAL = std::chrono::milliseconds(500);
+      static constexpr auto RATE_WINDOW     = std::chrono::seconds(5);
+
+      using Sample = std::pair<Clock::time_point, unsigned long long>;
+
+      unsigned long long       m_total;      /** total bytes to copy.                    */
+      unsigned long long       m_bytes;      /** bytes done.                             */
+      unsigned long long       m_skipped;    /** bytes done without copying them.        */
+      const Clock::time_point  m_start;      /** start time.                             */
+      Clock::time_point        m_lastReport; /** time of the last report.                */
+      std::deque<Sample>       m_samples;    /** copied bytes in the last RATE_WINDOW.   */
+      std::mutex               m_mutex;      /** protects the meter.                     */
+  };
+
+  /** \brief Returns the given bytes per second as a MB/s text.
+   * \param[in] rate Bytes per second.
+   *
+   */
+  QString megabytesPerSecond(const double rate)
+  {
+    return QString("%1 MB/s").arg(rate / (1024*1024), 0, 'f', 1);
+  }
+
+  /** \brief Returns true if the destination file has the size and modification time of the source
+   * file. The time is compared with a two seconds tolerance, the resolution of FAT file systems.
+   * \param[in] source Source file path.
+   * \param[in] destination Destination file path.
+   *
+   */
+  bool isAlreadyCopied(const std::filesystem::path &source, const std::filesystem::path &destination)
+  {
+    std::error_code error;
+    if(!std::filesystem::is_regular_file(destination, error)) return false;
+
+    const auto sourceSize      = std::filesystem::file_size(source, error);
+    const auto destinationSize = std::filesystem::file_size(destination, error);
+    if(error || sourceSize != destinationSize) return false;
+
+    const auto sourceTime      = std::filesystem::last_write_time(source, error);
+    const auto destinationTime = std::filesystem::last_write_time(destination, error);
+    if(error) return false;
+
+    const auto difference = (sourceTime > destinationTime) ? sourceTime - destinationTime : destinationTime - sourceTime;
+    return difference <= std::chrono::seconds(2);
+  }
+
+  /** \brief Sorts the given jobs by the physical position of their source files on the disk to reduce
+   * the seeks of rotational disks. Files without a known position go first. Returns false and leaves the
+   * jobs untouched if the positions are not available.
+   * \param[inout] jobs Copy jobs.
+   *
+   */
+  bool sortByDiskPosition(std::vector<CopyJob> &jobs)
+  {
+    std::vector<std::pair<unsigned long long, std::size_t>> positions;
+    positions.reserve(jobs.size());
+
+    bool available = false;
+    for(std::size_t i = 0; i < jobs.size(); ++i)
+    {
+      unsigned long long offset = 0;
+      available |= CopyEngine::physicalOffset(jobs.at(i).source, offset);
+      positions.emplace_back(offset, i);
+    }
+
+    if(!available) return false;
+
+    std::stable_sort(positions.begin(), positions.end());
+
+    std::vector<CopyJob> sorted;
+    sorted.reserve(jobs.size());
+    for(const auto &position: positions) sorted.push_back(std::move(jobs.at(position.second)));
+
+    jobs = std::move(sorted);
+    return true;
+  }
+}
 
 //-----------------------------------------------------------------------------
-CopyThread::CopyThread(std::vector<Utils::FileInformation> selectedDirs, std::wstring destination, QObject *parent)
+CopyThread::CopyThread(std::vector<Utils::FileInformation> selectedDirs, std::vector<std::wstring> destinations, const CopyConfiguration &configuration,
+                       QObject *parent)
 : QThread(parent)
 , m_abort(false)
 , m_selectedDirs(selectedDirs)
-, m_destination(destination)
+, m_destinations(destinations)
+, m_config(configuration)
 {
+  m_engine.setBandwidthLimit(m_config.bandwidth);
+  m_engine.setDurability(m_config.durability);
+  m_engine.setIOPriority(m_config.ioPriority);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<std::size_t> CopyThread::targets(const std::size_t position) const
+{
+  if(position < m_assignments.size()) return std::vector<std::size_t>(1, m_assignments.at(position));
+
+  std::vector<std::size_t> result(m_destinations.size());
+  std::iota(result.begin(), result.end(), 0);
+
+  return result;
 }
 
 //-----------------------------------------------------------------------------
 void CopyThread::run()
 {
-  unsigned long long accumulator = 0L;
-  auto printInfo = [&accumulator, this](const Utils::FileInformation &f)
+  CopyEngine::setThreadIOPriority(m_config.ioPriority);
+
+  const bool streaming = !m_streaming.base.empty();
+
+  auto printInfo = [this](const Utils::FileInformation &f)
   {
     QString message = tr("Selected: ") + QString::fromStdWString(f.first.filename().wstring()) + " (" + QString::number(f.second) + ")";
     log(message);
-
-    accumulator += f.second;
   };
   std::for_each(m_selectedDirs.cbegin(), m_selectedDirs.cend(), printInfo);
 
-  auto message = tr("Total bytes ") + QString::number(accumulator) + " in " + QString::number(m_selectedDirs.size()) + " directories.";
-  emit log(message);
+  // the selection sizes include the space overhead in the destination, the progress is measured in bytes
+  // of the files, so the given directories are listed before copying to know the total.
+  std::vector<std::vector<Utils::FileInformation>> listings;
+  unsigned long long totalBytes = 0;
 
-  emit log(tr("Copying directories..."));
+  auto listFiles = [&listings, &totalBytes, this](const std::size_t i, std::vector<Utils::FileInformation> &files, std::error_code &error)
+  {
+    if(i < listings.size())
+    {
+      files = std::move(listings.at(i));
+      return;
+    }
 
-  int i = 0;
-  emit progress(0);
+    try
+    {
+      files = Utils::getPlayableFiles(m_selectedDirs.at(i).first);
+    }
+    catch(const std::filesystem::filesystem_error &e)
+    {
+      error = e.code();
+      return;
+    }
+
+    for(const auto &file: files) totalBytes += file.second;
+  };
 
-  for(auto dir: m_selectedDirs)
+  if(streaming)
+  {
+    const auto base = QDir::toNativeSeparators(QString::fromStdWString(m_streaming.base.wstring()));
+    emit log(tr("Selecting from %1 for %2 bytes while copying...").arg(base).arg(m_streaming.size));
+  }
+  else
+  {
+    for(std::size_t i = 0; i < m_selectedDirs.size(); ++i)
+    {
+      std::vector<Utils::FileInformation> files;
+      std::error_code error;
+      listFiles(i, files, error);
+      if(error)
+      {
+        m_error = QString("Error while copying files of directory: ") + QString::fromStdWString(m_selectedDirs.at(i).first.wstring());
+        return;
+      }
+
+      listings.push_back(std::move(files));
+    }
+
+    auto message = tr("Total bytes ") + QString::number(totalBytes) + " in " + QString::number(m_selectedDirs.size()) + " directories.";
+    emit log(message);
+  }
+
+  if(m_destinations.size() > 1)
+  {
+    const auto mode = m_assignments.empty() ? tr("Copying to %1 destinations.") : tr("Splitting the directories between %1 destinations.");
+    emit log(mode.arg(m_destinations.size()));
+  }
+
+  std::mutex mutex;
+  std::vector<std::size_t> remaining;
+  std::vector<std::vector<std::size_t>> copyTargets;
+
+  // directories copied to every destination, in selection order.
+  std::vector<std::vector<std::size_t>> destinationDirs(m_destinations.size());
+
+  // verified files of every directory and destination, written next to the files when the directory is complete.
+  std::map<std::pair<std::size_t, std::size_t>, CopyManifest> manifests;
+
+  // adds the selected directory in the given position to the copy state, with the mutex locked if copying.
+  auto addDirectory = [&](const std::size_t i)
+  {
+    remaining.push_back(0);
+    copyTargets.emplace_back();
+
+    for(const auto d: targets(i))
+    {
+      destinationDirs.at(d).push_back(i);
+
+      const auto folder = std::filesystem::path(m_destinations.at(d)) / m_selectedDirs.at(i).first.filename();
+      manifests.emplace(std::piecewise_construct, std::forward_as_tuple(i, d), std::forward_as_tuple(folder));
+    }
+  };
+  for(std::size_t i = 0; i < m_selectedDirs.size(); ++i) addDirectory(i);
+
+  // position of the given directory in the journal of the given destination.
+  auto journalPosition = [&destinationDirs](const std::size_t d, const std::size_t i)
+  {
+    const auto &dirs = destinationDirs.at(d);
+    return static_cast<std::size_t>(std::distance(dirs.cbegin(), std::lower_bound(dirs.cbegin(), dirs.cend(), i)));
+  };
+
+  // every destination has a journal with its directories and the ones already copied to resume the copy if interrupted.
+  std::vector<CopyJournal> journals;
+  journals.reserve(m_destinations.size());
+  for(std::size_t d = 0; d < m_destinations.size(); ++d)
+  {
+    std::vector<Utils::FileInformation> dirs;
+    for(const auto i: destinationDirs.at(d)) dirs.push_back(m_selectedDirs.at(i));
+
+    journals.emplace_back(m_destinations.at(d));
+    auto &journal = journals.back();
+    const bool journalOk = m_config.resume ? journal.load() && journal.directories().size() == dirs.size() : journal.create(dirs);
+    if(!journalOk)
+    {
+      m_error = tr("Unable to write the copy journal in the destination directory: %1").arg(QString::fromStdWString(m_destinations.at(d)));
+      return;
+    }
+  }
+
+  for(const auto &dir: m_evictedDirs)
   {
     if(m_abort) return;
 
-    emit progress((100*i)/m_selectedDirs.size());
+    emit log(tr("Removing: %1").arg(QDir::toNativeSeparators(QString::fromStdWString(dir.first.wstring()))));
+
+    std::error_code error;
+    std::filesystem::remove_all(dir.first, error);
+    if(error)
+    {
+      m_error = QString("Error while removing directory: ") + QString::fromStdWString(dir.first.wstring());
+      return;
+    }
+  }
+
+  emit log(m_config.resume ? tr("Resuming copy...") : tr("Copying directories..."));
+
+  emit progress(0);
+
+  // several readers would interleave their jobs and seek between them, losing the disk order.
+  const auto threads = m_config.diskOrder ? 1U : std::max(1U, m_config.threads);
+  if(m_config.diskOrder)
+  {
+    if(m_config.threads > 1) emit log(tr("Copying in disk order with a single thread."));
+    if(streaming) emit log(tr("Copying the files of every selected directory in disk order."));
+  }
+
+  // the directories are created and listed here in order while the workers copy the files. When streaming
+  // the size limit is the estimation of the total until the selection ends.
+  WorkQueue<CopyJob> queue(threads * 16);
+  ThroughputMeter meter(streaming ? m_streaming.size : totalBytes);
+  std::size_t completed = 0;
+  std::atomic<bool> failed{false};
+  std::atomic<unsigned long long> skipped{0};
+  std::atomic<unsigned long long> verified{0};
+
+  auto setError = [&mutex, &failed, this](const std::size_t i)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!failed)
+    {
+      m_error = QString("Error while copying files of directory: ") + QString::fromStdWString(m_selectedDirs.at(i).first.wstring());
+      failed = true;
+    }
+  };
+
+  auto report = [this](const Transfer &transfer)
+  {
+    const auto total = transfer.total;
+    const auto value = total == 0 ? PROGRESS_MAXIMUM : (PROGRESS_MAXIMUM * std::min(transfer.bytes, total)) / total;
+    emit progress(std::max(1, static_cast<int>(value)));
+    emit throughput(transfer.rate, transfer.secondsLeft);
+  };
+
+  auto bytesCopied = [&meter, &report](const unsigned long long bytes)
+  {
+    Transfer transfer;
+    if(meter.add(bytes, transfer)) report(transfer);
+  };
+
+  auto bytesSkipped = [&meter, &report](const unsigned long long bytes)
+  {
+    Transfer transfer;
+    if(meter.skip(bytes, transfer)) report(transfer);
+  };
+
+  auto directoryCompleted = [&](const std::size_t i)
+  {
+    ++completed;
+    for(const auto d: copyTargets.at(i))
+    {
+      if(m_config.verify) manifests.at(std::make_pair(i, d)).save();
+      journals.at(d).setCompleted(journalPosition(d, i));
+    }
+
+    const auto transfer = meter.current();
+    const auto name = QString::fromStdWString(m_selectedDirs.at(i).first.filename().wstring());
+    emit log(tr("Copied: %1 (%2/%3, %4).").arg(name).arg(completed).arg(m_selectedDirs.size()).arg(megabytesPerSecond(transfer.rate)));
+  };
+
+  auto worker = [&]()
+  {
+    CopyEngine::setThreadIOPriority(m_config.ioPriority);
+
+    CopyJob job;
+    while(queue.pop(job))
+    {
+      if(m_abort || failed) continue;
+
+      // destinations that don't have the file yet. A verified copy needs the hash of the file, only
+      // known for the files in the manifest.
+      std::vector<std::filesystem::path> parts, destinations;
+      std::vector<std::size_t> pending;
+      for(std::size_t t = 0; t < job.targets.size(); ++t)
+      {
+        const auto &destination = job.destinations.at(t);
+
+        bool hasChecksum = !m_config.verify;
+        if(!hasChecksum)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          const auto entry = manifests.at(std::make_pair(job.directory, job.targets.at(t))).find(destination.filename());
+          std::error_code error;
+          hasChecksum = entry && (*entry).size == std::filesystem::file_size(destination, error);
+        }
+
+        if(hasChecksum && isAlreadyCopied(job.source, destination)) continue;
+
+        // copied with a temporary name and renamed when complete, so a partial file is never taken
+        // as a copied one. Existing different files are only replaced when resuming.
+        std::error_code error;
+        auto part = destination;
+        part += CopyJournal::PART_EXTENSION;
+        std::filesystem::remove(part, error);
+
+        if(std::filesystem::exists(destination, error) && !m_config.resume)
+        {
+          setError(job.directory);
+          break;
+        }
+
+        parts.push_back(part);
+        destinations.push_back(destination);
+        pending.push_back(job.targets.at(t));
+      }
+
+      if(failed) continue;
+
+      if(parts.empty())
+      {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(job.source, error);
+        if(!error) bytesSkipped(size);
+        ++skipped;
+      }
+      else
+      {
+        std::error_code error;
+        std::uint64_t checksum = 0;
+        if(!m_engine.copyFile(job.source, parts, error, bytesCopied, m_config.verify ? &checksum : nullptr))
+        {
+          setError(job.directory);
+          continue;
+        }
+
+        const auto time = std::filesystem::last_write_time(job.source, error);
+        for(std::size_t t = 0; t < parts.size() && !error; ++t)
+        {
+          std::filesystem::last_write_time(parts.at(t), time, error);
+          if(!error) std::filesystem::rename(parts.at(t), destinations.at(t), error);
+        }
+
+        if(error)
+        {
+          for(const auto &part: parts) std::filesystem::remove(part, error);
+          setError(job.directory);
+          continue;
+        }
+
+        if(m_config.verify)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          for(std::size_t t = 0; t < destinations.size(); ++t)
+          {
+            const CopyManifest::Entry entry{std::filesystem::file_size(destinations.at(t), error), checksum};
+            manifests.at(std::make_pair(job.directory, pending.at(t))).set(destinations.at(t).filename(), entry);
+          }
+          ++verified;
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if(--remaining.at(job.directory) == 0) directoryCompleted(job.directory);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(unsigned int i = 0; i < threads; ++i) workers.emplace_back(worker);
+
+  // streaming pipeline: the scanner passes the sized directories to the online selection, and the selected
+  // ones are listed and copied here as soon as they arrive.
+  WorkQueue<Utils::FileInformation> selected(std::numeric_limits<std::size_t>::max());
+  OnlineSelection selection(m_streaming.size, m_streaming.expected);
+  std::thread scanner;
+
+  if(streaming)
+  {
+    auto scan = [&]()
+    {
+      auto select = [&](std::vector<Utils::FileInformation> &&batch)
+      {
+        for(auto &dir: batch)
+        {
+          if(selection.offer(dir)) selected.push(std::move(dir));
+        }
+
+        return !m_abort && !failed;
+      };
+
+      try
+      {
+        CopyEngine::setThreadIOPriority(m_config.ioPriority);
+
+        if(Utils::streamSubdirectories(m_streaming.base, m_streaming.capacity, select, m_streaming.scanThreads, &m_abort))
+        {
+          for(auto &dir: selection.finish()) selected.push(std::move(dir));
+        }
+      }
+      catch(const std::exception &e)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!failed)
+        {
+          m_error = tr("Error while scanning the base directory: %1").arg(QString::fromLocal8Bit(e.what()));
+          failed = true;
+        }
+      }
+
+      selected.close();
+    };
+
+    scanner = std::thread(scan);
+  }
+
+  // next directory to copy, given or selected, in the given position.
+  std::size_t next = 0;
+  auto nextDirectory = [&](std::size_t &i)
+  {
+    if(!streaming)
+    {
+      if(next >= m_selectedDirs.size()) return false;
+
+      i = next++;
+      return true;
+    }
+
+    Utils::FileInformation dir;
+    if(!selected.pop(dir)) return false;
+
+    printInfo(dir);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    i = m_selectedDirs.size();
+    m_selectedDirs.push_back(std::move(dir));
+    addDirectory(i);
+
+    for(const auto d: targets(i))
+    {
+      if(!journals.at(d).add(m_selectedDirs.at(i)) && !failed)
+      {
+        m_error = tr("Unable to write the copy journal in the destination directory: %1").arg(QString::fromStdWString(m_destinations.at(d)));
+        failed = true;
+      }
+    }
+
+    return !failed;
+  };
+
+  // in disk order mode all the files are listed before copying to sort them, or the files of every
+  // directory when streaming so the copy doesn't wait for the end of the selection.
+  std::vector<CopyJob> pending;
+
+  std::size_t i = 0;
+  while(!m_abort && !failed && nextDirectory(i))
+  {
+    const auto &dir = m_selectedDirs.at(i);
+
+    // destinations that don't have the whole directory yet.
+    std::vector<std::size_t> dirTargets;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(const auto d: targets(i))
+      {
+        if(!journals.at(d).isCompleted(journalPosition(d, i))) dirTargets.push_back(d);
+      }
+
+      copyTargets.at(i) = dirTargets;
+    }
+
+    if(dirTargets.empty())
+    {
+      emit log(tr("Already copied: %1").arg(QDir::toNativeSeparators(QString::fromStdWString(dir.first.wstring()))));
+
+      std::vector<Utils::FileInformation> files;
+      std::error_code error;
+      listFiles(i, files, error);
+
+      unsigned long long bytes = 0;
+      for(const auto &file: files) bytes += file.second;
+      bytesSkipped(bytes);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      ++completed;
+      continue;
+    }
 
     emit log(tr("Copying: %1").arg(QDir::toNativeSeparators(QString::fromStdWString(dir.first.wstring()))));
 
-    if(!Utils::copyDirectory(dir.first.string(), m_destination))
+    std::error_code error;
+    std::vector<std::filesystem::path> folders;
+    for(const auto d: dirTargets)
     {
-      m_error = QString("Error while copying files of directory: ") + QString::fromStdWString(dir.first.wstring());
-      return;
+      folders.push_back(std::filesystem::path(m_destinations.at(d)) / dir.first.filename());
+      std::filesystem::create_directory(folders.back(), error);
+      if(error) break;
+
+      if(m_config.verify)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        manifests.at(std::make_pair(i, d)).load();
+      }
     }
 
-    ++i;
+    std::vector<Utils::FileInformation> files;
+    if(!error) listFiles(i, files, error);
+
+    if(error)
+    {
+      setError(i);
+      break;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      remaining.at(i) = files.size();
+      if(files.empty()) directoryCompleted(i);
+    }
+
+    for(auto &file: files)
+    {
+      std::vector<std::filesystem::path> destinations;
+      for(const auto &folder: folders) destinations.push_back(folder / file.first.filename());
+
+      CopyJob job{std::move(file.first), std::move(destinations), dirTargets, i};
+
+      if(m_config.diskOrder) pending.push_back(std::move(job));
+      else                   queue.push(std::move(job));
+    }
+
+    if(streaming && !pending.empty())
+    {
+      sortByDiskPosition(pending);
+
+      for(auto &job: pending)
+      {
+        if(m_abort || failed) break;
+        queue.push(std::move(job));
+      }
+
+      pending.clear();
+    }
   }
 
+  if(streaming)
+  {
+    scanner.join();
+
+    if(!m_abort && !failed)
+    {
+      meter.setTotal(totalBytes);
+
+      auto message = tr("Total bytes ") + QString::number(totalBytes) + " in " + QString::number(m_selectedDirs.size()) + " directories.";
+      emit log(message);
+    }
+  }
+
+  if(!pending.empty() && !m_abort && !failed)
+  {
+    if(sortByDiskPosition(pending)) emit log(tr("Reading %1 files in disk order.").arg(pending.size()));
+    else                            emit log(tr("Disk positions not available, reading files in path order."));
+
+    for(auto &job: pending)
+    {
+      if(m_abort || failed) break;
+      queue.push(std::move(job));
+    }
+  }
+
+  queue.close();
+  for(auto &thread: workers) thread.join();
+
+  if(m_abort || failed) return;
+
+  if(streaming && m_selectedDirs.empty())
+  {
+    for(auto &journal: journals) journal.remove();
+
+    m_error = tr("Unable to select directories for the given size: %1 bytes.").arg(m_streaming.size);
+    return;
+  }
+
+  // the copy is only finished when the data is on the device, it may be unplugged right after.
+  if(m_config.durability == CopyEngine::Durability::End)
+  {
+    emit log(tr("Flushing the copied data to the destination device..."));
+
+    for(const auto &destination: m_destinations)
+    {
+      std::error_code error;
+      if(!CopyEngine::syncFileSystem(destination, error))
+      {
+        m_error = tr("Error while flushing the copied data to the destination device: %1").arg(QString::fromStdWString(destination));
+        return;
+      }
+    }
+  }
+
+  for(auto &journal: journals) journal.remove();
+
+  if(skipped > 0) emit log(tr("Skipped %1 files already present in the destination.").arg(skipped.load()));
+  if(verified > 0) emit log(tr("Verified %1 copied files.").arg(verified.load()));
+
+  const auto transfer = meter.current();
+  emit log(tr("Copied %1 bytes in %2 seconds, average %3.").arg(transfer.copied).arg(transfer.seconds, 0, 'f', 1)
+                                                           .arg(megabytesPerSecond(transfer.averageRate)));
+
+  QStringList methods;
+  for(int i = 0; i < CopyEngine::METHODS_COUNT; ++i)
+  {
+    const auto method = static_cast<CopyEngine::Method>(i);
+    const auto count  = m_engine.filesCopied(method);
+    if(count > 0) methods << QString("%1 %2").arg(count).arg(CopyEngine::methodName(method));
+  }
+
+  if(!methods.isEmpty()) emit log(tr("Files copied by method: %1.").arg(methods.join(", ")));
+
   emit log(tr("Copy finished!"));
 
-  emit progress(100);
+  emit progress(PROGRESS_MAXIMUM);
 }
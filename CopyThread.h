@@ -22,22 +22,66 @@
 
 // Project
 #include <Utils.h>
+#include <CopyEngine.h>
 
 // Qt
 #include <QThread>
 
+// C++
+#include <atomic>
+#include <filesystem>
+#include <vector>
+
 class CopyThread
 : public QThread
 {
     Q_OBJECT
   public:
+    static constexpr int PROGRESS_MAXIMUM = 1000; /** progress value when all the bytes have been copied. */
+
+    /** \struct CopyConfiguration
+     * \brief Contains the copy settings.
+     *
+     */
+    struct CopyConfiguration
+    {
+        unsigned int           threads;    /** number of files to copy at the same time.                   */
+        bool                   verify;     /** true to verify the copied files and write their manifests.  */
+        bool                   resume;     /** true to resume the unfinished copy recorded in the journal. */
+        unsigned long long     bandwidth;  /** bandwidth limit in bytes per second, 0 to disable.          */
+        CopyEngine::IOPriority ioPriority; /** I/O priority of the copying threads.                        */
+        bool                   diskOrder;  /** true to read the files in disk order, in one thread.        */
+        CopyEngine::Durability durability; /** when the copied data is flushed to the device.              */
+
+        CopyConfiguration(): threads{1}, verify{false}, resume{false}, bandwidth{0}, ioPriority{CopyEngine::IOPriority::Normal}, diskOrder{false},
+                             durability{CopyEngine::Durability::End} {};
+    };
+
+    /** \struct StreamingSelection
+     * \brief Settings to select the directories to copy while the base directory is scanned, copying
+     * every selected directory right away.
+     *
+     */
+    struct StreamingSelection
+    {
+        std::filesystem::path base;        /** base directory to select from, empty to copy the given ones. */
+        unsigned long long    size;        /** size limit in bytes.                                         */
+        unsigned long long    expected;    /** expected size of all the candidates, 0 if unknown.           */
+        Utils::Capacity       capacity;    /** capacity model of the destinations.                          */
+        unsigned int          scanThreads; /** number of scanning threads, 0 to use one per core.           */
+
+        StreamingSelection(): size{0}, expected{0}, scanThreads{1} {};
+    };
+
     /** \brief CopyThread class constructor.
      * \param[in] selectedDirs List of selected directories to copy.
-     * \param[in] destination Destination directory path.
+     * \param[in] destinations Destination directories paths, every file is read once and written to all of them.
+     * \param[in] configuration Copy settings.
      * \param[in] parent Raw pointer of the object parent of this one.
      *
      */
-    explicit CopyThread(std::vector<Utils::FileInformation> selectedDirs, std::wstring destination, QObject *parent = nullptr);
+    explicit CopyThread(std::vector<Utils::FileInformation> selectedDirs, std::vector<std::wstring> destinations,
+                        const CopyConfiguration &configuration = CopyConfiguration(), QObject *parent = nullptr);
 
     /** \brief CopyThread class virtual destructor.
      *
@@ -45,6 +89,36 @@ class CopyThread
     virtual ~CopyThread()
     {};
 
+    /** \brief Sets the destination directories to remove before copying.
+     * \param[in] directories Destination directories.
+     *
+     */
+    void setEvictedDirectories(std::vector<Utils::FileInformation> directories)
+    { m_evictedDirs = std::move(directories); }
+
+    /** \brief Sets the destination of every selected directory, to split the directories between the
+     * destinations instead of copying all of them to every destination.
+     * \param[in] assignments Position of the destination of every selected directory, in selection order.
+     *
+     */
+    void setAssignments(std::vector<std::size_t> assignments)
+    { m_assignments = std::move(assignments); }
+
+    /** \brief Selects the directories to copy from the given base directory while copying, instead of
+     * copying the directories given in the constructor.
+     * \param[in] selection Streaming selection settings.
+     *
+     */
+    void setStreamingSelection(const StreamingSelection &selection)
+    { m_streaming = selection; }
+
+    /** \brief Changes the bandwidth limit of the copy, can be called while copying.
+     * \param[in] bytesPerSecond Bandwidth limit in bytes per second, 0 to disable the limit.
+     *
+     */
+    void setBandwidthLimit(const unsigned long long bytesPerSecond)
+    { m_engine.setBandwidthLimit(bytesPerSecond); }
+
     /** \brief Stops the process.
      *
      */
@@ -66,15 +140,27 @@ class CopyThread
   signals:
     void log(const QString &message);
     void progress(int);
+    void throughput(const double bytesPerSecond, const int secondsLeft);
 
   protected:
     virtual void run();
 
   private:
-    bool                                      m_abort;        /** true if aborted, false otherwise.  */
-    QString                                   m_error;        /** error message or empty if success. */
-    const std::vector<Utils::FileInformation> m_selectedDirs; /** list of directories to copy.       */
-    const std::wstring                        m_destination;  /** destination directory.             */
+    /** \brief Returns the positions of the destinations of the selected directory in the given position.
+     * \param[in] position Position of the selected directory.
+     *
+     */
+    std::vector<std::size_t> targets(const std::size_t position) const;
+
+    std::atomic<bool>                         m_abort;        /** true if aborted, false otherwise.            */
+    QString                                   m_error;        /** error message or empty if success.           */
+    std::vector<Utils::FileInformation>       m_selectedDirs; /** list of directories to copy.                 */
+    const std::vector<std::wstring>           m_destinations; /** destination directories.                     */
+    std::vector<Utils::FileInformation>       m_evictedDirs;  /** directories to remove before copying.        */
+    std::vector<std::size_t>                  m_assignments;  /** destination of every directory, empty for all. */
+    StreamingSelection                        m_streaming;    /** streaming selection settings.                */
+    const CopyConfiguration                   m_config;       /** copy settings.                               */
+    CopyEngine                                m_engine;       /** file copy engine.                            */
 };
 
 #endif // COPYTHREAD_H_
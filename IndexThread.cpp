@@ -0,0 +1,45 @@
+/*
+ File: IndexThread.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <IndexThread.h>
+
+//-----------------------------------------------------------------------------
+IndexThread::IndexThread(const std::filesystem::path &directory, const unsigned int threads, QObject *parent)
+: QThread(parent)
+, m_abort{false}
+, m_directory{directory}
+, m_threads{threads}
+{
+}
+
+//-----------------------------------------------------------------------------
+void IndexThread::run()
+{
+  try
+  {
+    auto directories = Utils::scanDirectoryTree(m_directory, m_threads, &m_abort);
+
+    if(!m_abort) m_index = LibraryIndex(std::move(directories));
+  }
+  catch(const std::filesystem::filesystem_error &)
+  {
+    m_index = LibraryIndex();
+  }
+}
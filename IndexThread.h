@@ -0,0 +1,83 @@
+/*
+ File: IndexThread.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INDEXTHREAD_H_
+#define INDEXTHREAD_H_
+
+// Project
+#include <LibraryIndex.h>
+
+// Qt
+#include <QThread>
+
+// C++
+#include <atomic>
+
+/** \class IndexThread
+ * \brief Scans the base directory in the background to refresh the library index.
+ *
+ */
+class IndexThread
+: public QThread
+{
+    Q_OBJECT
+  public:
+    /** \brief IndexThread class constructor.
+     * \param[in] directory Base directory to scan.
+     * \param[in] threads Number of scanning threads, 0 to use one per core.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit IndexThread(const std::filesystem::path &directory, const unsigned int threads, QObject *parent = nullptr);
+
+    /** \brief IndexThread class virtual destructor.
+     *
+     */
+    virtual ~IndexThread()
+    {};
+
+    /** \brief Stops the scan.
+     *
+     */
+    void stop()
+    { m_abort = true; }
+
+    /** \brief Returns true if the thread was aborted and false otherwise.
+     *
+     */
+    bool isAborted() const
+    { return m_abort; }
+
+    /** \brief Returns the scanned index, only valid after the thread has finished.
+     *
+     */
+    const LibraryIndex &index() const
+    { return m_index; }
+
+  protected:
+    virtual void run();
+
+  private:
+    std::atomic<bool>           m_abort;     /** true if aborted, false otherwise. */
+    const std::filesystem::path m_directory; /** base directory to scan.           */
+    const unsigned int          m_threads;   /** number of scanning threads.       */
+    LibraryIndex                m_index;     /** scanned index.                    */
+};
+
+#endif // INDEXTHREAD_H_
@@ -0,0 +1,262 @@
+/*
+ File: LibraryIndex.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <LibraryIndex.h>
+
+// Qt
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+
+// C++
+#include <algorithm>
+#include <numeric>
+
+const quint32 INDEX_MAGIC     = 0x4E504958; // "NPIX"
+const quint32 INDEX_VERSION   = 1;
+const qint64  MIN_RECORD_SIZE = 12;         // bytes of a directory or file record with an empty name.
+
+//-----------------------------------------------------------------------------
+LibraryIndex::LibraryIndex(std::vector<Utils::DirectoryInformation> directories)
+: m_directories{std::move(directories)}
+{
+  computeSubtrees();
+}
+
+//-----------------------------------------------------------------------------
+std::filesystem::path LibraryIndex::baseDirectory() const
+{
+  if(m_directories.empty()) return std::filesystem::path();
+
+  return m_directories.front().path;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t LibraryIndex::subdirectoriesCount() const
+{
+  return m_directories.empty() ? 0 : m_directories.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long LibraryIndex::subdirectoriesSpace(const Utils::Capacity &capacity) const
+{
+  const auto directories = Utils::copySpaces(m_directories, capacity, 1);
+
+  auto addOp = [](const unsigned long long &s, const Utils::FileInformation &d) { return s + d.second; };
+  return std::accumulate(directories.cbegin(), directories.cend(), 0ULL, addOp);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> LibraryIndex::playableFiles(const std::filesystem::path &directory) const
+{
+  std::vector<Utils::FileInformation> files;
+
+  const auto position = find(directory);
+  if(position >= 0)
+  {
+    for(auto i = static_cast<std::size_t>(position); i < m_subtreeEnd.at(position); ++i)
+    {
+      const auto &dirFiles = m_directories.at(i).files;
+      std::copy(dirFiles.cbegin(), dirFiles.cend(), std::back_inserter(files));
+    }
+
+    std::sort(files.begin(), files.end(), Utils::lessThan);
+  }
+
+  return files;
+}
+
+//-----------------------------------------------------------------------------
+bool LibraryIndex::load(const QString &filename)
+{
+  QFile file(filename);
+  if(!file.open(QFile::ReadOnly)) return false;
+
+  QDataStream stream(&file);
+
+  quint32 magic = 0, version = 0;
+  stream >> magic >> version;
+  if(magic != INDEX_MAGIC || version != INDEX_VERSION) return false;
+
+  QString baseName;
+  quint64 count = 0;
+  stream >> baseName >> count;
+  if(stream.status() != QDataStream::Ok) return false;
+
+  const std::filesystem::path base = baseName.toStdWString();
+
+  // the counts come from a file that can be damaged, the reserved memory is limited by the records that
+  // fit in the rest of the file. Any error discards the index so it's scanned again.
+  auto maxRecords = [&file]() { return static_cast<quint64>(std::max<qint64>(0, file.size() - file.pos())) / MIN_RECORD_SIZE; };
+
+  std::vector<Utils::DirectoryInformation> directories;
+  try
+  {
+    directories.reserve(std::min(count, maxRecords()));
+
+    for(quint64 i = 0; i < count; ++i)
+    {
+      QString name;
+      quint64 filesCount = 0;
+      stream >> name >> filesCount;
+      if(stream.status() != QDataStream::Ok) return false;
+
+      Utils::DirectoryInformation directory{name.isEmpty() ? base : base / name.toStdWString(), {}};
+      directory.files.reserve(std::min(filesCount, maxRecords()));
+
+      for(quint64 j = 0; j < filesCount; ++j)
+      {
+        QString fileName;
+        quint64 size = 0;
+        stream >> fileName >> size;
+        if(stream.status() != QDataStream::Ok) return false;
+
+        directory.files.emplace_back(directory.path / fileName.toStdWString(), size);
+      }
+
+      directories.push_back(std::move(directory));
+    }
+  }
+  catch(const std::exception &)
+  {
+    return false;
+  }
+
+  // the sub-trees are computed from the order, the base directory first and the rest sorted by path.
+  auto lessThanPath = [](const Utils::DirectoryInformation &lhs, const Utils::DirectoryInformation &rhs) { return lhs.path < rhs.path; };
+  if(directories.empty() || directories.front().path != base || !std::is_sorted(directories.cbegin(), directories.cend(), lessThanPath)) return false;
+
+  m_directories = std::move(directories);
+  computeSubtrees();
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool LibraryIndex::save(const QString &filename) const
+{
+  QDir().mkpath(QFileInfo(filename).absolutePath());
+
+  QSaveFile file(filename);
+  if(!file.open(QFile::WriteOnly)) return false;
+
+  QDataStream stream(&file);
+
+  const auto base = baseDirectory();
+  stream << INDEX_MAGIC << INDEX_VERSION;
+  stream << QString::fromStdWString(base.wstring()) << static_cast<quint64>(m_directories.size());
+
+  for(const auto &directory: m_directories)
+  {
+    const auto relative = (directory.path == base) ? std::filesystem::path() : directory.path.lexically_relative(base);
+    stream << QString::fromStdWString(relative.wstring()) << static_cast<quint64>(directory.files.size());
+
+    for(const auto &f: directory.files)
+    {
+      stream << QString::fromStdWString(f.first.filename().wstring()) << static_cast<quint64>(f.second);
+    }
+  }
+
+  return file.commit();
+}
+
+//-----------------------------------------------------------------------------
+QString LibraryIndex::indexFilename()
+{
+  QSettings settings(QSettings::IniFormat, QSettings::UserScope, "Felix de las Pozas Alvarez", "NowPlay");
+
+  return QFileInfo(settings.fileName()).absolutePath() + "/NowPlay.index";
+}
+
+//-----------------------------------------------------------------------------
+void LibraryIndex::computeSubtrees()
+{
+  Utils::linkDirectoryTree(m_directories);
+
+  // directories are sorted by path, so a sub-tree ends where the last sub-tree of its children ends.
+  m_subtreeEnd.resize(m_directories.size());
+  for(std::size_t i = 0; i < m_directories.size(); ++i) m_subtreeEnd.at(i) = i + 1;
+
+  for(std::size_t i = m_directories.size(); i-- > 1;)
+  {
+    const auto parent = m_directories.at(i).parent;
+    if(parent != i) m_subtreeEnd.at(parent) = std::max(m_subtreeEnd.at(parent), m_subtreeEnd.at(i));
+  }
+
+  // children of every directory stored contiguously, the offsets are the prefix sum of the children count.
+  m_childrenOffsets.assign(m_directories.size() + 1, 0);
+  for(std::size_t i = 1; i < m_directories.size(); ++i) ++m_childrenOffsets.at(m_directories.at(i).parent + 1);
+  for(std::size_t i = 1; i < m_childrenOffsets.size(); ++i) m_childrenOffsets.at(i) += m_childrenOffsets.at(i - 1);
+
+  m_children.resize(m_directories.empty() ? 0 : m_directories.size() - 1);
+  auto next = m_childrenOffsets;
+  for(std::size_t i = 1; i < m_directories.size(); ++i) m_children.at(next.at(m_directories.at(i).parent)++) = i;
+}
+
+//-----------------------------------------------------------------------------
+std::filesystem::path LibraryIndex::randomSubdirectory(std::default_random_engine &generator) const
+{
+  if(subdirectoriesCount() == 0) return std::filesystem::path();
+
+  std::size_t node = 0;
+  while(true)
+  {
+    // the node can be chosen with probability 1/(directories of its sub-tree), except the base directory.
+    const auto candidates = m_subtreeEnd.at(node) - node - (node == 0 ? 1 : 0);
+
+    std::uniform_int_distribution<std::size_t> distribution(0, candidates - 1);
+    auto roll = distribution(generator);
+
+    if(node != 0)
+    {
+      if(roll == 0) return m_directories.at(node).path;
+      --roll;
+    }
+
+    // the sub-trees of the children follow the node in order, so the child whose sub-tree contains
+    // the roll position is chosen with a probability proportional to its number of directories.
+    const auto target = node + 1 + roll;
+    const auto first = m_children.cbegin() + m_childrenOffsets.at(node);
+    const auto last  = m_children.cbegin() + m_childrenOffsets.at(node + 1);
+
+    // a damaged tree can leave the node without the child of the roll, the walk stops at the node then.
+    const auto child = std::upper_bound(first, last, target);
+    if(child == first)
+    {
+      return node == 0 ? std::filesystem::path() : m_directories.at(node).path;
+    }
+
+    node = *(child - 1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+long long LibraryIndex::find(const std::filesystem::path &directory) const
+{
+  auto lessThanPath = [](const Utils::DirectoryInformation &d, const std::filesystem::path &p) { return d.path < p; };
+  const auto it = std::lower_bound(m_directories.cbegin(), m_directories.cend(), directory, lessThanPath);
+
+  if(it == m_directories.cend() || (*it).path != directory) return -1;
+
+  return std::distance(m_directories.cbegin(), it);
+}
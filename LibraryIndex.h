@@ -0,0 +1,127 @@
+/*
+ File: LibraryIndex.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBRARYINDEX_H_
+#define LIBRARYINDEX_H_
+
+// Project
+#include <Utils.h>
+
+// Qt
+#include <QString>
+
+// C++
+#include <filesystem>
+#include <random>
+#include <vector>
+
+/** \class LibraryIndex
+ * \brief Snapshot of the directories and playable files of a base directory that can be
+ * stored on disk to avoid scanning the base directory every time.
+ *
+ */
+class LibraryIndex
+{
+  public:
+    /** \brief LibraryIndex class constructor. Creates an empty index.
+     *
+     */
+    LibraryIndex()
+    {};
+
+    /** \brief LibraryIndex class constructor.
+     * \param[in] directories Scanned directories as returned by Utils::scanDirectoryTree().
+     *
+     */
+    explicit LibraryIndex(std::vector<Utils::DirectoryInformation> directories);
+
+    /** \brief Returns true if the index has data and false otherwise.
+     *
+     */
+    bool isValid() const
+    { return !m_directories.empty(); }
+
+    /** \brief Returns the base directory of the index.
+     *
+     */
+    std::filesystem::path baseDirectory() const;
+
+    /** \brief Returns the number of sub-directories of the base directory.
+     *
+     */
+    std::size_t subdirectoriesCount() const;
+
+    /** \brief Returns the sum of the spaces the copies of the sub-trees of all the sub-directories would
+     * take in a destination with the given capacity, the size of all the candidates of a copy selection.
+     * \param[in] capacity Destination capacity.
+     *
+     */
+    unsigned long long subdirectoriesSpace(const Utils::Capacity &capacity) const;
+
+    /** \brief Returns a random sub-directory of the base directory, with the same probability for all
+     * of them, or an empty path if there are none. Walks down the tree choosing at each level a child
+     * weighted by the number of directories of its sub-tree, so the cost depends only on the depth.
+     * \param[in] generator Random number generator.
+     *
+     */
+    std::filesystem::path randomSubdirectory(std::default_random_engine &generator) const;
+
+    /** \brief Returns the list of playable files of the given directory and its sub-directories.
+     * Returns an empty list if the directory is not in the index.
+     * \param[in] directory Absolute path of an indexed directory.
+     *
+     */
+    std::vector<Utils::FileInformation> playableFiles(const std::filesystem::path &directory) const;
+
+    /** \brief Loads the index from the given file. Returns true on success and false otherwise.
+     * \param[in] filename Index file path.
+     *
+     */
+    bool load(const QString &filename);
+
+    /** \brief Saves the index to the given file. Returns true on success and false otherwise.
+     * \param[in] filename Index file path.
+     *
+     */
+    bool save(const QString &filename) const;
+
+    /** \brief Returns the path of the index file, stored next to the application settings.
+     *
+     */
+    static QString indexFilename();
+
+  private:
+    /** \brief Computes the end of the sub-tree of every directory.
+     *
+     */
+    void computeSubtrees();
+
+    /** \brief Returns the position of the given directory in the index or -1 if not found.
+     * \param[in] directory Absolute directory path.
+     *
+     */
+    long long find(const std::filesystem::path &directory) const;
+
+    std::vector<Utils::DirectoryInformation> m_directories;     /** indexed directories sorted by path, base first.      */
+    std::vector<std::size_t>                 m_subtreeEnd;      /** one past the last directory of each sub-tree.        */
+    std::vector<std::size_t>                 m_childrenOffsets; /** start of the children of each directory in m_children. */
+    std::vector<std::size_t>                 m_children;        /** children positions grouped by parent, in path order.  */
+};
+
+#endif // LIBRARYINDEX_H_
@@ -0,0 +1,212 @@
+/*
+ File: M3UPlaylist.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <M3UPlaylist.h>
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+const std::string M3U_HEADER = "#EXTM3U";
+const std::string UTF8_BOM   = "\xEF\xBB\xBF";
+
+namespace
+{
+  /** \brief Returns true if the given text is valid UTF-8 and false otherwise.
+   * \param[in] text Text bytes.
+   *
+   */
+  bool isUTF8(const std::string &text)
+  {
+    std::size_t continuation = 0;
+    for(const auto c: text)
+    {
+      const auto byte = static_cast<unsigned char>(c);
+
+      if(continuation > 0)
+      {
+        if((byte & 0xC0) != 0x80) return false;
+        --continuation;
+        continue;
+      }
+
+      if(byte < 0x80)                continuation = 0;
+      else if((byte & 0xE0) == 0xC0) continuation = 1;
+      else if((byte & 0xF0) == 0xE0) continuation = 2;
+      else if((byte & 0xF8) == 0xF0) continuation = 3;
+      else return false;
+    }
+
+    return continuation == 0;
+  }
+
+  /** \brief Returns the UTF-8 text of the given Latin-1 text.
+   * \param[in] text Latin-1 text.
+   *
+   */
+  std::string latin1ToUTF8(const std::string &text)
+  {
+    std::string result;
+    result.reserve(text.size() * 2);
+
+    for(const auto c: text)
+    {
+      const auto byte = static_cast<unsigned char>(c);
+      if(byte < 0x80)
+      {
+        result.push_back(c);
+      }
+      else
+      {
+        result.push_back(static_cast<char>(0xC0 | (byte >> 6)));
+        result.push_back(static_cast<char>(0x80 | (byte & 0x3F)));
+      }
+    }
+
+    return result;
+  }
+}
+
+//-----------------------------------------------------------------------------
+M3UPlaylist::M3UPlaylist(const std::filesystem::path &filename)
+: m_filename{filename}
+{
+}
+
+//-----------------------------------------------------------------------------
+bool M3UPlaylist::load()
+{
+  std::ifstream input(m_filename, std::ios::in|std::ios::binary);
+  if(!input) return false;
+
+  const std::string data{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+  if(input.bad()) return false;
+
+  auto extension = m_filename.extension().string();
+  Utils::toLower(extension);
+  const auto isUTF8Playlist = (extension == ".m3u8");
+
+  const auto directory = m_filename.parent_path();
+
+  std::vector<std::filesystem::path> entries;
+
+  std::size_t start = data.compare(0, UTF8_BOM.size(), UTF8_BOM) == 0 ? UTF8_BOM.size() : 0;
+  while(start < data.size())
+  {
+    auto end = data.find('\n', start);
+    if(end == std::string::npos) end = data.size();
+
+    auto first = start;
+    auto last  = end;
+    start = end + 1;
+
+    while(first < last && std::isspace(static_cast<unsigned char>(data[first])))    ++first;
+    while(last > first && std::isspace(static_cast<unsigned char>(data[last - 1]))) --last;
+
+    // comments and extended information start with '#', URLs can't be checked on disk.
+    if(first == last || data[first] == '#') continue;
+
+    auto line = data.substr(first, last - first);
+    if(line.find("://") != std::string::npos) continue;
+
+    if(!isUTF8Playlist && !isUTF8(line)) line = latin1ToUTF8(line);
+
+    auto path = std::filesystem::u8path(line);
+    if(path.is_relative()) path = directory / path;
+
+    entries.push_back(path.lexically_normal());
+  }
+
+  m_entries = std::move(entries);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool M3UPlaylist::save() const
+{
+  // the whole playlist is written at once.
+  std::string data = M3U_HEADER + '\n';
+  for(const auto &entry: m_entries)
+  {
+    data += std::filesystem::path(entry).make_preferred().u8string();
+    data += '\n';
+  }
+
+  std::ofstream output(m_filename, std::ios::out|std::ios::trunc|std::ios::binary);
+  if(!output) return false;
+
+  output.write(data.data(), data.size());
+
+  return static_cast<bool>(output.flush());
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> M3UPlaylist::playableEntries(unsigned int threads) const
+{
+  if(threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+
+  // every thread checks a contiguous range of entries, files that can't be played keep an empty path.
+  std::vector<Utils::FileInformation> files(m_entries.size());
+
+  auto checkEntries = [this, &files](const std::size_t first, const std::size_t last)
+  {
+    for(auto i = first; i < last; ++i)
+    {
+      const auto &entry = m_entries.at(i);
+
+      const auto kind = Utils::mediaKindFromExtension(entry);
+      if(kind != Utils::MediaKind::Audio && kind != Utils::MediaKind::Video) continue;
+
+      std::error_code error;
+      if(!std::filesystem::is_regular_file(entry, error)) continue;
+
+      const auto size = std::filesystem::file_size(entry, error);
+      if(!error) files.at(i) = Utils::FileInformation{entry, size};
+    }
+  };
+
+  const auto count = std::min<std::size_t>(threads, m_entries.size());
+  if(count <= 1)
+  {
+    checkEntries(0, m_entries.size());
+  }
+  else
+  {
+    const auto step = (m_entries.size() + count - 1) / count;
+
+    std::vector<std::thread> workers;
+    for(std::size_t first = 0; first < m_entries.size(); first += step)
+    {
+      workers.emplace_back(checkEntries, first, std::min(first + step, m_entries.size()));
+    }
+
+    for(auto &worker: workers) worker.join();
+  }
+
+  auto isEmpty = [](const Utils::FileInformation &f) { return f.first.empty(); };
+  files.erase(std::remove_if(files.begin(), files.end(), isEmpty), files.end());
+
+  return files;
+}
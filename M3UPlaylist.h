@@ -0,0 +1,93 @@
+/*
+ File: M3UPlaylist.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef M3UPLAYLIST_H_
+#define M3UPLAYLIST_H_
+
+// Project
+#include <Utils.h>
+
+// C++
+#include <filesystem>
+#include <vector>
+
+/** \class M3UPlaylist
+ * \brief List of files of a M3U or M3U8 playlist file. Playlists are written in UTF-8 with absolute
+ * paths. When reading, comments and remote entries are skipped, relative paths are resolved from the
+ * playlist directory, and lines of .m3u files that are not valid UTF-8 are read as Latin-1. Not thread-safe.
+ *
+ */
+class M3UPlaylist
+{
+  public:
+    /** \brief M3UPlaylist class constructor. Creates an empty playlist.
+     * \param[in] filename Playlist file path.
+     *
+     */
+    explicit M3UPlaylist(const std::filesystem::path &filename);
+
+    /** \brief Loads the entries of the playlist file. Returns true on success and false otherwise.
+     *
+     */
+    bool load();
+
+    /** \brief Stores the entries in the playlist file. Returns true on success and false otherwise.
+     *
+     */
+    bool save() const;
+
+    /** \brief Adds the given file at the end of the playlist.
+     * \param[in] file Absolute file path.
+     *
+     */
+    void add(const std::filesystem::path &file)
+    { m_entries.push_back(file); }
+
+    /** \brief Reserves space for the given number of entries.
+     * \param[in] count Number of entries.
+     *
+     */
+    void reserve(const std::size_t count)
+    { m_entries.reserve(count); }
+
+    /** \brief Returns the files of the playlist in order.
+     *
+     */
+    const std::vector<std::filesystem::path> &entries() const
+    { return m_entries; }
+
+    /** \brief Returns the entries that are existing audio or video files with their sizes, in order. The
+     * entries are checked in parallel.
+     * \param[in] threads Number of checking threads, 0 to use one per core and 1 to check serially.
+     *
+     */
+    std::vector<Utils::FileInformation> playableEntries(unsigned int threads = 0) const;
+
+    /** \brief Returns the playlist file path.
+     *
+     */
+    const std::filesystem::path &filename() const
+    { return m_filename; }
+
+  private:
+    const std::filesystem::path        m_filename; /** playlist file path.       */
+    std::vector<std::filesystem::path> m_entries;  /** playlist files in order.  */
+};
+
+#endif // M3UPLAYLIST_H_
@@ -19,6 +19,7 @@
 
 // C++
 #include <algorithm>
+#include <numeric>
 #include <random>
 #include <vector>
 #include <string>
@@ -30,6 +31,10 @@
 #include "version.h"
 #include "AboutDialog.h"
 #include "SettingsDialog.h"
+#include "CopyJournal.h"
+#include "CastCommandChannel.h"
+#include "CastOutputParser.h"
+#include "M3UPlaylist.h"
 
 // Qt
 #include <QSettings>
@@ -47,6 +52,7 @@
 #include <QFile>
 #include <QTextStream>
 #include <QPainter>
+#include <QTemporaryFile>
 
 // Win64 builds
 #ifdef __WIN64__
@@ -68,17 +74,41 @@ const QString VIDPLAYER_LOC = "Video player location";
 const QString CASTNOW_LOC   = "Castnow Location";
 const QString THEME         = "Application Theme";
 const QString CONTINUOUS    = "Continuous Play";
+const QString SCAN_THREADS  = "Scanner Threads";
+const QString COPY_THREADS  = "Copy Threads";
+const QString VERIFY_COPY   = "Verify Copied Files";
+const QString SYNC_COPY     = "Sync Destination";
+const QString KEEP_PERCENT  = "Sync Keep Percentage";
+const QString BANDWIDTH     = "Copy Bandwidth Limit";
+const QString IO_PRIORITY   = "Copy Disk Priority";
+const QString DISK_ORDER    = "Copy In Disk Order";
+const QString SPLIT_COPY    = "Split Between Destinations";
+const QString DURABILITY    = "Copy Flush Policy";
 
 const unsigned long long MEGABYTE = 1024*1024;
 
+const QChar DESTINATION_SEPARATOR = ';'; // separates the copy destination directories.
+
+const qint64 INDEX_REFRESH_INTERVAL = 10*60*1000; // minimum milliseconds between index refreshes.
+
+const int STOP_TIMEOUT = 1000; // milliseconds to wait for castnow to stop the playback and quit.
+
+const QString AUDIO_PLAYLIST = "NowPlay-audio-XXXXXX.m3u8"; // temporary playlists for the music player.
+const QString VIDEO_PLAYLIST = "NowPlay-video-XXXXXX.m3u8"; // temporary playlists for the video player.
+
 //-----------------------------------------------------------------------------
 NowPlay::NowPlay()
 : QDialog     {nullptr}
 , m_process   {this}
-, m_command   {this}
+, m_commands  {&m_process, this}
+, m_parser    {this}
 , m_continuous{false}
+, m_scanThreads{0}
 , m_icon      {new QSystemTrayIcon(QIcon(":/NowPlay/buttons.svg"), this)}
 , m_thread    {nullptr}
+, m_indexThread{nullptr}
+, m_prepareThread{nullptr}
+, m_castPending{false}
 #ifdef __WIN64__
 , m_taskBarButton{nullptr}
 #endif
@@ -101,6 +131,19 @@ NowPlay::NowPlay()
 //-----------------------------------------------------------------------------
 NowPlay::~NowPlay()
 {
+  if(m_indexThread)
+  {
+    m_indexThread->blockSignals(true);
+    m_indexThread->stop();
+    m_indexThread->wait();
+  }
+
+  if(m_prepareThread)
+  {
+    m_prepareThread->blockSignals(true);
+    m_prepareThread->wait();
+  }
+
   saveSettings();
 }
 
@@ -131,6 +174,45 @@ void NowPlay::loadSettings()
 
   m_units->setCurrentIndex(copyUnits);
 
+  const auto copyThreads = settings.value(COPY_THREADS, 2).toInt();
+
+  m_copyThreads->setValue(copyThreads);
+
+  const auto verifyCopy = settings.value(VERIFY_COPY, false).toBool();
+
+  // the copies can't be verified where the destination can't be read back skipping the cache.
+  m_verify->setChecked(verifyCopy && CopyEngine::canVerify());
+  m_verify->setEnabled(CopyEngine::canVerify());
+  if(!CopyEngine::canVerify()) m_verify->setToolTip(tr("Copied files can't be verified on this system."));
+
+  const auto syncCopy    = settings.value(SYNC_COPY, false).toBool();
+  const auto keepPercent = settings.value(KEEP_PERCENT, 50).toInt();
+
+  m_sync->setChecked(syncCopy);
+  m_keepPercent->setValue(keepPercent);
+  m_keepPercent->setEnabled(syncCopy);
+
+  const auto splitCopy = settings.value(SPLIT_COPY, false).toBool();
+
+  m_split->setChecked(splitCopy);
+
+  const auto bandwidth  = settings.value(BANDWIDTH, 0).toInt();
+  const auto ioPriority = settings.value(IO_PRIORITY, 0).toInt();
+
+  m_bandwidth->setValue(bandwidth);
+  m_ioPriority->setCurrentIndex(ioPriority);
+
+  const auto diskOrder = settings.value(DISK_ORDER, false).toBool();
+
+  m_diskOrder->setChecked(diskOrder);
+
+  const auto durability = settings.value(DURABILITY, static_cast<int>(CopyEngine::Durability::End)).toInt();
+
+  // without a way to flush the data the system decides when it's written.
+  m_durability->setCurrentIndex(CopyEngine::canFlush() ? durability : static_cast<int>(CopyEngine::Durability::None));
+  m_durability->setEnabled(CopyEngine::canFlush());
+  if(!CopyEngine::canFlush()) m_durability->setToolTip(tr("Copied data can't be flushed on this system."));
+
   const auto useAudio = settings.value(USE_AUDPLAYER, false).toBool();
   const auto useVideo = settings.value(USE_VIDPLAYER, false).toBool();
 
@@ -149,6 +231,7 @@ void NowPlay::loadSettings()
   m_castnowPath  = settings.value(CASTNOW_LOC,  "").toString();
 
   m_continuous = settings.value(CONTINUOUS, false).toBool();
+  m_scanThreads = settings.value(SCAN_THREADS, 0).toUInt();
 
   const auto theme = settings.value(THEME, QString()).toString();
 
@@ -159,6 +242,8 @@ void NowPlay::loadSettings()
     QTextStream ts(&file);
     qApp->setStyleSheet(ts.readAll());
   }
+
+  m_index.load(LibraryIndex::indexFilename());
 }
 
 //-----------------------------------------------------------------------------
@@ -171,6 +256,15 @@ void NowPlay::saveSettings()
   settings.setValue(DESTINATION,   m_destinationDir->text());
   settings.setValue(COPYSIZE,      m_amount->currentIndex());
   settings.setValue(COPYUNITS,     m_units->currentIndex());
+  settings.setValue(COPY_THREADS,  m_copyThreads->value());
+  settings.setValue(VERIFY_COPY,   m_verify->isChecked());
+  settings.setValue(SYNC_COPY,     m_sync->isChecked());
+  settings.setValue(KEEP_PERCENT,  m_keepPercent->value());
+  settings.setValue(SPLIT_COPY,    m_split->isChecked());
+  settings.setValue(BANDWIDTH,     m_bandwidth->value());
+  settings.setValue(IO_PRIORITY,   m_ioPriority->currentIndex());
+  settings.setValue(DISK_ORDER,    m_diskOrder->isChecked());
+  settings.setValue(DURABILITY,    m_durability->currentIndex());
   settings.setValue(USE_AUDPLAYER, m_useMusicPlayer->isChecked());
   settings.setValue(USE_VIDPLAYER, m_useVideoPlayer->isChecked());
   settings.setValue(SUBTITLESIZE,  static_cast<double>(m_subtitleSizeSlider->value()/10.));
@@ -178,6 +272,7 @@ void NowPlay::saveSettings()
   settings.setValue(VIDPLAYER_LOC, m_videoPlayerPath);
   settings.setValue(CASTNOW_LOC,   m_castnowPath);
   settings.setValue(CONTINUOUS,    m_continuous);
+  settings.setValue(SCAN_THREADS,  m_scanThreads);
   settings.setValue(THEME,         qApp->styleSheet().isEmpty() ? QString():"dark");
 
   settings.sync();
@@ -199,34 +294,30 @@ bool NowPlay::callWinamp()
 
   WinAmp::deletePlaylist(handler);
 
-  auto isPlaylist = [this](const Utils::FileInformation &f){ return Utils::isPlaylistFile(f.first); };
-  auto it = std::find_if(m_files.cbegin(), m_files.cend(), isPlaylist);
-  if(it != m_files.cend())
+  if(m_files.playlistCount() > 0)
   {
-    const auto filename = QString::fromStdWString((*it).first.wstring());
+    const auto filename = QString::fromStdWString(m_files.playlists().front().first.wstring());
     WinAmp::addFile(handler, QDir::toNativeSeparators(filename).toStdWString());
   }
   else
   {
-    auto checkAndAdd = [&](const Utils::FileInformation &f)
+    if(m_files.audioCount() == 0)
+    {
+      const auto directory = m_files.empty() ? std::filesystem::path() : m_files.media().front().first.parent_path();
+      const auto message = tr("No playable files found in directory: ") + QString::fromStdWString(directory.wstring());
+      showErrorMessage(message);
+      return false;
+    }
+
+    auto addAudio = [&](const Utils::FileInformation &f)
     {
       if(Utils::isAudioFile(f.first))
       {
         const auto filename = QString::fromStdWString(f.first.wstring());
         WinAmp::addFile(handler, QDir::toNativeSeparators(filename).toStdWString());
-        return true;
       }
-
-      return false;
     };
-    auto count = std::count_if(m_files.cbegin(), m_files.cend(), checkAndAdd);
-
-    if(count == 0)
-    {
-      const auto message = tr("No playable files found in directory: ") + QString::fromStdWString(m_files.front().first.parent_path().wstring());
-      showErrorMessage(message);
-      return false;
-    }
+    std::for_each(m_files.media().cbegin(), m_files.media().cend(), addAudio);
   }
 
   m_files.clear();
@@ -246,14 +337,29 @@ void NowPlay::playVideos()
   arguments << "-no-close-at-end";
   arguments << "-add-to-playlist";
 
-  auto addToArguments = [&arguments](const Utils::FileInformation &f)
+  M3UPlaylist playlist(temporaryPlaylistFilename(VIDEO_PLAYLIST));
+  playlist.reserve(m_files.videoCount());
+
+  auto addToPlaylist = [&playlist](const Utils::FileInformation &f)
   {
     if(Utils::isVideoFile(f.first))
     {
-      arguments << QString::fromStdWString(f.first.wstring());
+      playlist.add(f.first);
     }
   };
-  std::for_each(m_files.cbegin(), m_files.cend(), addToArguments);
+  std::for_each(m_files.media().cbegin(), m_files.media().cend(), addToPlaylist);
+
+  if(playlist.save())
+  {
+    arguments << QString::fromStdWString(playlist.filename().wstring());
+  }
+  else
+  {
+    log(tr("<b><font color =\"red\">Unable to write the playlist:</font></b> ") + QString::fromStdWString(playlist.filename().wstring()));
+
+    auto addToArguments = [&arguments](const std::filesystem::path &file) { arguments << QString::fromStdWString(file.wstring()); };
+    std::for_each(playlist.entries().cbegin(), playlist.entries().cend(), addToArguments);
+  }
 
   m_process.startDetached(m_videoPlayerPath, arguments);
 
@@ -269,9 +375,13 @@ void NowPlay::castFile()
 
     sendCommand("s");
     sendCommand("quit");
+    m_commands.flush(STOP_TIMEOUT);
 
-    m_process.kill();
-    m_process.waitForFinished(-1);
+    if(!m_process.waitForFinished(STOP_TIMEOUT))
+    {
+      m_process.kill();
+      m_process.waitForFinished(-1);
+    }
     m_files.clear();
 
     m_process.blockSignals(false);
@@ -283,14 +393,40 @@ void NowPlay::castFile()
 
   if(!m_castnow->isChecked() || !Utils::checkIfValidCastnowLocation(m_castnowPath)) return;
 
-  auto isValidFile = [](const Utils::FileInformation &f){ return Utils::isAudioFile(f.first) || Utils::isVideoFile(f.first); };
-  auto file = std::find_if(m_files.begin(), m_files.end(), isValidFile);
-  if(file != m_files.end())
+  castNextFile();
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::castNextFile()
+{
+  m_castPending = false;
+
+  while(m_files.playableCount() > 0)
   {
-    const auto filename = (*file).first;
-    m_files.erase(file);
+    // the file is usually prepared while the previous one played, otherwise the cast starts when it's prepared.
+    const auto &next = m_files.media().front().first;
+    if(!m_prepareThread || m_prepareThread->file() != next || !m_prepareThread->isFinished())
+    {
+      m_castPending = true;
+      m_play->setText("Stop");
+      prepareFile(next);
+      return;
+    }
+
+    if(m_prepareThread->isReady()) break;
+
+    Utils::FileInformation file;
+    m_files.pop(file);
+
+    setProgress(m_progress->value() + 1);
+    log(tr("<b><font color =\"red\">Unable to read!</font></b> ") + QString::fromStdWString(file.first.wstring()));
+  }
 
-    const auto hasMoreFiles = (!m_files.empty() && std::count_if(m_files.cbegin(), m_files.cend(), isValidFile) > 0);
+  Utils::FileInformation file;
+  if(m_files.pop(file))
+  {
+    const auto filename = file.first;
+    const auto hasMoreFiles = m_files.playableCount() > 0;
 
     m_play->setText("Stop");
     m_next->setEnabled(hasMoreFiles || m_continuous);
@@ -309,9 +445,15 @@ void NowPlay::castFile()
       arguments << m_subtitleSizeLabel->text();
     }
 
+    m_parser.reset();
+    m_progress->setFormat("%p%");
+
     m_process.start(m_castnowPath, arguments, QProcess::Unbuffered|QProcess::ReadWrite);
     m_process.waitForStarted();
 
+    // validated and read ahead while the current file plays, the handoff only waits for castnow.
+    if(m_files.playableCount() > 0) prepareFile(m_files.media().front().first);
+
     const auto title   = QString::fromStdWString(filename.parent_path().filename().wstring());
     const auto message = QString::fromStdWString(filename.filename().wstring()) + tr(" (%1/%2)").arg(m_progress->value()).arg(m_progress->maximum());
 	
@@ -343,21 +485,48 @@ void NowPlay::castFile()
   }
 }
 
+//-----------------------------------------------------------------------------
+void NowPlay::prepareFile(const std::filesystem::path &file)
+{
+  if(m_prepareThread && (m_prepareThread->isRunning() || m_prepareThread->file() == file)) return;
+
+  m_prepareThread = std::make_shared<PrepareThread>(file, this);
+
+  connect(m_prepareThread.get(), SIGNAL(finished()), this, SLOT(onFilePrepared()));
+
+  m_prepareThread->start();
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onFilePrepared()
+{
+  // the thread is kept with its result until the file is cast or another one is prepared.
+  if(m_castPending && sender() == m_prepareThread.get()) castNextFile();
+}
+
 //-----------------------------------------------------------------------------
 void NowPlay::connectSignals()
 {
   connect(m_tabWidget,          SIGNAL(currentChanged(int)), this, SLOT(onTabChanged(int)));
   connect(m_browseBase,         SIGNAL(pressed()),           this, SLOT(browseDir()));
   connect(m_browseDestination,  SIGNAL(pressed()),           this, SLOT(browseDir()));
+  connect(m_addDestination,     SIGNAL(pressed()),           this, SLOT(browseDir()));
   connect(m_about,              SIGNAL(pressed()),           this, SLOT(onAboutButtonClicked()));
   connect(m_play,               SIGNAL(pressed()),           this, SLOT(onPlayButtonClicked()));
   connect(m_next,               SIGNAL(pressed()),           this, SLOT(playNext()));
   connect(m_exit,               SIGNAL(pressed()),           this, SLOT(close()));
   connect(m_settings,           SIGNAL(pressed()),           this, SLOT(onSettingsButtonClicked()));
   connect(m_subtitleSizeSlider, SIGNAL(valueChanged(int)),   this, SLOT(onSubtitleSizeChanged(int)));
+  connect(m_sync,               SIGNAL(toggled(bool)),       m_keepPercent, SLOT(setEnabled(bool)));
+  connect(m_bandwidth,          SIGNAL(valueChanged(int)),   this, SLOT(onBandwidthChanged(int)));
 
   connect(&m_process, SIGNAL(readyReadStandardOutput()), this, SLOT(onOuttputAvailable()));
+  connect(&m_parser, SIGNAL(playing()),                      this, SLOT(onCastPlaying()));
+  connect(&m_parser, SIGNAL(position(const int, const int)), this, SLOT(onCastPosition(const int, const int)));
+  connect(&m_parser, SIGNAL(idle()),                         this, SLOT(onCastIdle()), Qt::QueuedConnection);
+  connect(&m_parser, SIGNAL(error(const QString &)),         this, SLOT(onCastError(const QString &)), Qt::QueuedConnection);
   connect(&m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(castFile()));
+  connect(&m_commands, SIGNAL(commandSent(const QString &, const double, const bool)), this, SLOT(onCastCommandSent(const QString &, const double, const bool)));
 
   connect(m_icon, SIGNAL(activated(QSystemTrayIcon::ActivationReason)), this, SLOT(onTrayIconActivated(QSystemTrayIcon::ActivationReason)));
 }
@@ -372,6 +541,17 @@ void NowPlay::onTabChanged(int index)
 //-----------------------------------------------------------------------------
 void NowPlay::onPlayButtonClicked()
 {
+  // stopped while waiting for the preparation of the next file, its result is ignored.
+  if(m_castPending)
+  {
+    m_castPending = false;
+    m_files.clear();
+
+    resetState();
+
+    return;
+  }
+
   if(m_process.state() == QProcess::Running)
   {
     QApplication::setOverrideCursor(Qt::WaitCursor);
@@ -380,9 +560,13 @@ void NowPlay::onPlayButtonClicked()
 
     sendCommand("s");
     sendCommand("quit");
+    m_commands.flush(STOP_TIMEOUT);
 
-    m_process.kill();
-    m_process.waitForFinished(-1);
+    if(!m_process.waitForFinished(STOP_TIMEOUT))
+    {
+      m_process.kill();
+      m_process.waitForFinished(-1);
+    }
     m_files.clear();
 
     m_process.blockSignals(false);
@@ -426,9 +610,7 @@ void NowPlay::onPlayButtonClicked()
         {
           if(m_castnow->isChecked())
           {
-            const auto count = std::count_if(m_files.cbegin(), m_files.cend(), [](const Utils::FileInformation &f){ return Utils::isAudioFile(f.first) || Utils::isVideoFile(f.first); });
-
-            setProgressRange(0, count);
+            setProgressRange(0, m_files.playableCount());
 
             setProgress(0);
 
@@ -455,8 +637,7 @@ void NowPlay::onPlayButtonClicked()
 
   const bool isCopyMode = m_tabWidget->currentIndex() == 1;
 
-  std::filesystem::path directory = QDir::fromNativeSeparators(m_baseDir->text()).toStdWString();
-  auto validPaths = Utils::getSubdirectories(directory, isCopyMode);
+  std::filesystem::path directory = Utils::normalizedDirectory(QDir::fromNativeSeparators(m_baseDir->text()).toStdWString());
 
   // Copy mode
   if(isCopyMode)
@@ -478,9 +659,18 @@ void NowPlay::onPlayButtonClicked()
       return;
     }
 
-    const auto destination = m_destinationDir->text().toStdWString();
+    std::vector<std::wstring> destinations;
+    for(const auto &path: m_destinationDir->text().split(DESTINATION_SEPARATOR, QString::SkipEmptyParts))
+    {
+      // listed and compared by path components, a trailing separator would hide its contents.
+      const auto destination = Utils::normalizedDirectory(path.trimmed().toStdWString()).wstring();
+      if(destination.empty()) continue;
+      if(std::find(destinations.cbegin(), destinations.cend(), destination) == destinations.cend()) destinations.push_back(destination);
+    }
+
+    const auto destination = destinations.empty() ? std::wstring() : destinations.front();
     bool ok = false;
-    auto size = m_amount->currentText().toInt(&ok, 10);
+    unsigned long long size = m_amount->currentText().toULongLong(&ok, 10);
 
     if(!ok)
     {
@@ -488,18 +678,88 @@ void NowPlay::onPlayButtonClicked()
       return;
     }
 
-    if(destination.empty() || !std::filesystem::exists(destination) || !std::filesystem::is_directory(destination))
+    if(destinations.empty())
     {
       showErrorMessage(tr("No destination directory to copy to."));
       return;
     }
 
-    if (validPaths.empty())
+    for(const auto &path: destinations)
     {
-      showErrorMessage(tr("No sub-directories to select from."));
+      if(path.empty() || !std::filesystem::exists(path) || !std::filesystem::is_directory(path))
+      {
+        showErrorMessage(tr("Invalid destination directory: %1").arg(QString::fromStdWString(path)));
+        return;
+      }
+    }
+
+    if(m_sync->isChecked() && destinations.size() > 1)
+    {
+      showErrorMessage(tr("Sync mode can only refresh one destination directory."));
       return;
     }
 
+    const bool split = m_split->isChecked() && destinations.size() > 1;
+
+    // every destination of a copy has a journal with the directories copied to it.
+    auto hasJournal = [](const std::wstring &path) { return CopyJournal::exists(path); };
+    if(std::all_of(destinations.cbegin(), destinations.cend(), hasJournal))
+    {
+      QMessageBox msgBox(this);
+      msgBox.setWindowIcon(QIcon(":/NowPlay/buttons.svg"));
+      msgBox.setWindowTitle(tr("Now Play!"));
+      msgBox.setText(tr("The destination directory has an unfinished copy. Do you want to resume it?"));
+      msgBox.setIcon(QMessageBox::Icon::Question);
+      msgBox.setStandardButtons(QMessageBox::Button::No|QMessageBox::Button::Yes);
+
+      if(QMessageBox::Button::Yes == msgBox.exec())
+      {
+        std::vector<CopyJournal> journals;
+        auto loadJournal = [&journals](const std::wstring &path) { journals.emplace_back(path); return journals.back().load(); };
+        if(std::all_of(destinations.cbegin(), destinations.cend(), loadJournal))
+        {
+          // the same directories in all the journals is a copy to every destination, otherwise they were split.
+          auto sameDirectories = [&journals](const CopyJournal &j) { return j.directories() == journals.front().directories(); };
+          std::vector<Utils::FileInformation> resumed;
+          std::vector<std::size_t> assignments;
+
+          if(std::all_of(journals.cbegin(), journals.cend(), sameDirectories))
+          {
+            resumed = journals.front().directories();
+          }
+          else
+          {
+            for(std::size_t i = 0; i < journals.size(); ++i)
+            {
+              const auto dirs = journals.at(i).directories();
+              std::copy(dirs.cbegin(), dirs.cend(), std::back_inserter(resumed));
+              assignments.insert(assignments.end(), dirs.size(), i);
+            }
+          }
+
+          log(tr("Resuming the copy of %1 directories.").arg(resumed.size()));
+          startCopy(resumed, destinations, true, std::vector<Utils::FileInformation>(), assignments);
+          return;
+        }
+
+        log(tr("Unable to read the copy journal, starting a new copy."));
+      }
+    }
+
+    // the selection is planned with the space the files take in the destinations, with the biggest block size.
+    std::vector<Utils::Capacity> capacities(destinations.size());
+    Utils::Capacity capacity;
+    for(std::size_t i = 0; i < destinations.size(); ++i)
+    {
+      if(!Utils::getCapacity(destinations.at(i), capacities.at(i)))
+      {
+        showErrorMessage(tr("Unable to get the free space of the destination directory: %1").arg(QString::fromStdWString(destinations.at(i))));
+        return;
+      }
+
+      capacity.blockSize = std::max(capacity.blockSize, capacities.at(i).blockSize);
+    }
+
     switch(m_units->currentIndex())
     {
       case 1:
@@ -513,30 +773,162 @@ void NowPlay::onPlayButtonClicked()
         break;
     }
 
+    // space that can be filled in the given destination, two blocks are left for the copy journal.
+    auto freeSpace = [&capacities, &capacity](const std::size_t i)
+    {
+      const auto reserved = 2 * capacity.blockSize;
+      return capacities.at(i).available > reserved ? capacities.at(i).available - reserved : 0ULL;
+    };
+
+    // sync mode can also use the space of the directories it removes.
+    std::vector<Utils::FileInformation> existing;
+    unsigned long long existingSize = 0;
+    if(m_sync->isChecked())
+    {
+      existing = Utils::getChildDirectories(destination, capacity, m_scanThreads);
+
+      auto addOp = [](const unsigned long long &s, const Utils::FileInformation &f) { return s + f.second; };
+      existingSize = std::accumulate(existing.cbegin(), existing.cend(), 0ULL, addOp);
+    }
+
+    // split mode fills every destination up to the amount or its free space, with different directories.
+    std::vector<unsigned long long> sizes(split ? destinations.size() : 1, size);
+    for(std::size_t i = 0; i < destinations.size(); ++i)
+    {
+      auto &limit = sizes.at(split ? i : 0);
+      const auto available = freeSpace(i) + existingSize;
+      if(available < limit)
+      {
+        log(tr("Amount limited to the free space of %1: %2 bytes.").arg(QString::fromStdWString(destinations.at(i))).arg(available));
+        limit = available;
+      }
+    }
+    size = sizes.front();
+
+    // a plain copy selects the directories while scanning the base directory and starts copying the first
+    // ones right away, the whole tree is only scanned first when the selection needs all the candidates.
+    if(!m_sync->isChecked() && !split)
+    {
+      CopyThread::StreamingSelection streaming;
+      streaming.base        = directory;
+      streaming.size        = size;
+      streaming.expected    = (m_index.isValid() && m_index.baseDirectory() == directory) ? m_index.subdirectoriesSpace(capacity) : 0;
+      streaming.capacity    = capacity;
+      streaming.scanThreads = m_scanThreads;
+
+      startCopy(std::vector<Utils::FileInformation>(), destinations, false, std::vector<Utils::FileInformation>(), std::vector<std::size_t>(),
+                streaming);
+      return;
+    }
+
+    auto validPaths = Utils::getSubdirectories(directory, capacity, m_scanThreads);
+
+    if (validPaths.empty())
+    {
+      showErrorMessage(tr("No sub-directories to select from."));
+      return;
+    }
+
     QString message = tr("Selecting from base for ") + QString::number(size) + " bytes...";
     log(message);
 
-    auto selectedDirs = Utils::getCopyDirectories(validPaths, size);
+    QElapsedTimer timer;
+    timer.start();
+
+    // sync mode only selects the changes to the destination contents.
+    Utils::SyncSelection sync;
+    if(m_sync->isChecked())
+    {
+      sync = Utils::getSyncDirectories(validPaths, existing, size, m_keepPercent->value() / 100.);
+    }
+
+    std::vector<std::size_t> assignments;
+    std::vector<Utils::FileInformation> selectedDirs;
+
+    if(m_sync->isChecked())
+    {
+      selectedDirs = sync.copy;
+    }
+    else if(split)
+    {
+      // directories of the destinations interleaved, so the copy threads write to all of them at the same time.
+      const auto parts = Utils::getCopyDirectories(validPaths, sizes);
+      auto lessThanSize = [](const std::vector<Utils::FileInformation> &lhs, const std::vector<Utils::FileInformation> &rhs) { return lhs.size() < rhs.size(); };
+      const auto rounds = parts.empty() ? 0 : (*std::max_element(parts.cbegin(), parts.cend(), lessThanSize)).size();
+      for(std::size_t j = 0; j < rounds; ++j)
+      {
+        for(std::size_t i = 0; i < parts.size(); ++i)
+        {
+          if(j >= parts.at(i).size()) continue;
+
+          selectedDirs.push_back(parts.at(i).at(j));
+          assignments.push_back(i);
+        }
+      }
+    }
+    else
+    {
+      selectedDirs = Utils::getCopyDirectories(validPaths, size);
+    }
+
+    const auto elapsed = timer.elapsed();
+
+    auto addOp = [](const unsigned long long &s, const Utils::FileInformation &f) { return s + f.second; };
+    const auto keptSize = std::accumulate(sync.keep.cbegin(), sync.keep.cend(), 0ULL, addOp);
+
+    if(m_sync->isChecked())
+    {
+      const auto evictedSize = std::accumulate(sync.evict.cbegin(), sync.evict.cend(), 0ULL, addOp);
+
+      log(tr("Sync: keeping %1 directories (%2 bytes), removing %3 directories (%4 bytes).").arg(sync.keep.size()).arg(keptSize)
+                                                                                            .arg(sync.evict.size()).arg(evictedSize));
+
+      if(selectedDirs.empty())
+      {
+        if(sync.evict.empty())
+        {
+          log(tr("Nothing to change in the destination directory."));
+        }
+        else
+        {
+          startCopy(selectedDirs, destinations, false, sync.evict);
+        }
+
+        return;
+      }
+    }
 
     if(!selectedDirs.empty())
     {
-      m_thread = std::make_shared<CopyThread>(selectedDirs, destination, this);
+      const auto selectedSize = std::accumulate(selectedDirs.cbegin(), selectedDirs.cend(), 0ULL, addOp);
+      const auto requested = std::accumulate(sizes.cbegin(), sizes.cend(), 0ULL);
+      const auto fillRatio = (100. * (keptSize + selectedSize)) / requested;
 
-      connect(m_thread.get(), SIGNAL(log(const QString &)), this, SLOT(log(const QString &)));
-      connect(m_thread.get(), SIGNAL(progress(const int)), this, SLOT(setProgress(const int)));
-      connect(m_thread.get(), SIGNAL(finished()), this, SLOT(onCopyFinished()));
+      log(tr("Selected %1 directories in %2 ms, %3 bytes (%4% of the requested size).").arg(selectedDirs.size()).arg(elapsed)
+                                                                                     .arg(selectedSize).arg(fillRatio, 0, 'f', 2));
 
-      m_play->setText("Stop");
-      m_tabWidget->setEnabled(false);
-      QApplication::setOverrideCursor(Qt::WaitCursor);
+      for(std::size_t i = 0; split && i < destinations.size(); ++i)
+      {
+        std::size_t count = 0;
+        unsigned long long bytes = 0;
+        for(std::size_t j = 0; j < assignments.size(); ++j)
+        {
+          if(assignments.at(j) != i) continue;
+          bytes += selectedDirs.at(j).second;
+          ++count;
+        }
 
-      m_thread->start();
+        log(tr("Destination %1: %2 directories, %3 of %4 bytes.").arg(QString::fromStdWString(destinations.at(i))).arg(count).arg(bytes)
+                                                                 .arg(sizes.at(i)));
+      }
+
+      startCopy(selectedDirs, destinations, false, sync.evict, assignments);
 
       return;
     }
     else
     {
-      const auto message = tr("Unable to select directories for the given size: ") + QString::number(size) + " " + m_units->currentText() + ".";
+      const auto message = tr("Unable to select directories for the given size: ") + QString::number(size) + " bytes.";
       showErrorMessage(message);
       return;
     }
@@ -544,19 +936,35 @@ void NowPlay::onPlayButtonClicked()
     return;
   }
 
-  // Play mode.
-  if(!validPaths.empty())
+  // Play mode serves the selection from the index, if any, and refreshes it in the background. Without
+  // index the base directory is sampled in a single pass.
+  const bool useIndex = m_index.isValid() && m_index.baseDirectory() == directory;
+
+  refreshIndex(directory);
+
+  std::size_t count = 0;
+  std::filesystem::path selected;
+
+  if(useIndex)
   {
-    QString message = tr("<b>") + QDir::toNativeSeparators(QString::fromStdWString(directory.wstring())) + tr("</b> has ") + QString::number(validPaths.size()) + tr(" directories.");
-    log(message);
+    count = m_index.subdirectoriesCount();
 
     unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
     std::default_random_engine generator(seed);
 
-    std::uniform_int_distribution<int> distribution(1, validPaths.size());
-    int roll = distribution(generator);
+    selected = m_index.randomSubdirectory(generator);
+  }
+  else
+  {
+    selected = Utils::getRandomSubdirectory(directory, count);
+  }
+
+  if(!selected.empty())
+  {
+    QString message = tr("<b>") + QDir::toNativeSeparators(QString::fromStdWString(directory.wstring())) + tr("</b> has ") + QString::number(count) + tr(" directories.");
+    log(message);
 
-    directory = validPaths.at(roll-1).first;
+    directory = selected;
 
     message = QString("Selected: <b>") + QString::fromStdWString(directory.filename().wstring()) + tr("</b>");
     log(message);
@@ -567,8 +975,18 @@ void NowPlay::onPlayButtonClicked()
     log(message);
   }
 
-  auto files = Utils::getPlayableFiles(directory);
-  std::move(files.begin(), files.end(), std::back_inserter(m_files));
+  std::vector<Utils::FileInformation> files;
+  if(useIndex)
+  {
+    files = m_index.playableFiles(directory);
+
+    auto isMissing = [](const Utils::FileInformation &f) { return !std::filesystem::exists(f.first); };
+    files.erase(std::remove_if(files.begin(), files.end(), isMissing), files.end());
+  }
+
+  if(files.empty()) files = Utils::getPlayableFiles(directory, m_scanThreads);
+
+  m_files.merge(PlaybackQueue(std::move(files)));
 
   if(!m_files.empty())
   {
@@ -583,9 +1001,7 @@ void NowPlay::onPlayButtonClicked()
     {
       if(m_castnow->isChecked())
       {
-        const auto count = std::count_if(m_files.cbegin(), m_files.cend(), [](const Utils::FileInformation &f){ return Utils::isAudioFile(f.first) || Utils::isVideoFile(f.first); });
-
-        setProgressRange(0, count);
+        setProgressRange(0, m_files.playableCount());
 
         setProgress(0);
 
@@ -630,13 +1046,20 @@ void NowPlay::browseDir()
   else
   {
     title = tr("Select destination directory");
-    dir = m_destinationDir->text();
+    dir = m_destinationDir->text().section(DESTINATION_SEPARATOR, -1);
     widget = m_destinationDir;
   }
 
   auto newDirectory = QFileDialog::getExistingDirectory(this, title, dir);
 
-  if(!newDirectory.isEmpty()) widget->setText(QDir::toNativeSeparators(newDirectory));
+  if(!newDirectory.isEmpty())
+  {
+    // the add button appends the directory to the list of destinations.
+    auto text = QDir::toNativeSeparators(newDirectory);
+    if(origin == m_addDestination && !widget->text().isEmpty()) text = widget->text() + DESTINATION_SEPARATOR + text;
+
+    widget->setText(text);
+  }
 
   if(origin) origin->setDown(false);
 }
@@ -760,23 +1183,53 @@ bool NowPlay::event(QEvent *event)
 //-----------------------------------------------------------------------------
 void NowPlay::onOuttputAvailable()
 {
-  const auto data = QString(m_process.readAll()).toStdString();
-  auto pos = data.find("Idle...");
-  if(std::string::npos != pos)
+  m_parser.parse(m_process);
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onCastPlaying()
+{
+  if(m_gapTimer.isValid())
   {
-    m_process.kill();
-    m_process.waitForFinished(-1);
-    return;
+    log(tr("Gap between tracks: %1 ms").arg(m_gapTimer.elapsed()));
+    m_gapTimer.invalidate();
   }
+}
 
-  pos = data.find("Error: Load failed");
-  if(std::string::npos != pos)
+//-----------------------------------------------------------------------------
+void NowPlay::onCastPosition(const int seconds, const int duration)
+{
+  auto toText = [](const int t)
   {
-    log(tr("<b><font color =\"red\">Unable to play!</font></b>"));
+    const auto minutesAndSeconds = QString("%1:%2").arg((t / 60) % 60, 2, 10, QChar('0')).arg(t % 60, 2, 10, QChar('0'));
+    return (t < 3600) ? minutesAndSeconds : QString("%1:").arg(t / 3600) + minutesAndSeconds;
+  };
 
-    m_process.kill();
-    m_process.waitForFinished(-1);
-  }
+  m_progress->setFormat(tr("%v/%m - %1 / %2").arg(toText(seconds)).arg(toText(duration)));
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onCastIdle()
+{
+  // queued, the process could have been replaced since.
+  if(m_parser.state() != CastOutputParser::State::Idle) return;
+
+  m_gapTimer.start();
+
+  m_process.kill();
+  m_process.waitForFinished(-1);
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onCastError(const QString &message)
+{
+  // queued, the process could have been replaced since.
+  if(m_parser.state() != CastOutputParser::State::Error) return;
+
+  log(tr("<b><font color =\"red\">Unable to play!</font></b> ") + message.toHtmlEscaped());
+
+  m_process.kill();
+  m_process.waitForFinished(-1);
 }
 
 //-----------------------------------------------------------------------------
@@ -789,6 +1242,8 @@ void NowPlay::onSubtitleSizeChanged(int value)
 //-----------------------------------------------------------------------------
 void NowPlay::playNext()
 {
+  m_gapTimer.start();
+
   m_process.kill();
   m_process.waitForFinished(-1);
 }
@@ -803,6 +1258,7 @@ void NowPlay::onSettingsButtonClicked()
   config.videoPlayerPath = m_videoPlayerPath;
   config.castnowPath = m_castnowPath;
   config.continuous = m_continuous;
+  config.scanThreads = m_scanThreads;
 
   SettingsDialog dialog(config, this);
   if(QDialog::Accepted == dialog.exec())
@@ -811,6 +1267,7 @@ void NowPlay::onSettingsButtonClicked()
     m_videoPlayerPath = dialog.getVideoPlayerLocation();
     m_castnowPath = dialog.getCastnowLocation();
     m_continuous = dialog.getContinuousPlay();
+    m_scanThreads = dialog.getScanThreads();
 
     checkApplications();
   }
@@ -957,6 +1414,7 @@ void NowPlay::setProgress(const int value)
   if(value == 0)
   {
     m_progress->setEnabled(false);
+    m_progress->setFormat("%p%");
 
     m_icon->setToolTip((m_tabWidget->currentIndex() == 0) ? tr("Now Play!") : tr("Now Copy!"));
   }
@@ -990,15 +1448,32 @@ void NowPlay::dropEvent(QDropEvent *e)
     {
       const auto fileList = data->urls();
 
+      std::vector<Utils::FileInformation> playlistFiles;
       for(auto filePath: fileList)
       {
         auto file = std::filesystem::path(filePath.toLocalFile().toStdWString());
-        if(std::filesystem::is_regular_file(file) && (Utils::isAudioFile(file) || Utils::isVideoFile(file)))
+        if(!std::filesystem::is_regular_file(file)) continue;
+
+        if(Utils::isAudioFile(file) || Utils::isVideoFile(file))
         {
           files.emplace_back(file,0);
         }
+        else if(Utils::isPlaylistFile(file))
+        {
+          // the entries are queued instead of the playlist, so they can be cast too.
+          M3UPlaylist playlist(file);
+          if(playlist.load())
+          {
+            auto entries = playlist.playableEntries(m_scanThreads);
+            std::move(entries.begin(), entries.end(), std::back_inserter(playlistFiles));
+          }
+        }
       }
 
+      // the playlists keep their order after the dropped files.
+      std::sort(files.begin(), files.end(), Utils::lessThan);
+      std::move(playlistFiles.begin(), playlistFiles.end(), std::back_inserter(files));
+
       if(!files.empty())
       {
         if(!m_files.empty())
@@ -1034,22 +1509,20 @@ void NowPlay::dropEvent(QDropEvent *e)
           }
         }
 
-        std::sort(files.begin(), files.end(), Utils::lessThan);
-
-        auto addFileToPlaylist = [this](const Utils::FileInformation &f)
+        auto logAdded = [this](const Utils::FileInformation &f)
         {
           log(tr("Added to current playlist: %1").arg(QString::fromStdWString(f.first.filename().wstring())));
-          m_files.push_back(std::move(f));
         };
-        std::for_each(files.cbegin(), files.cend(), addFileToPlaylist);
+        std::for_each(files.cbegin(), files.cend(), logAdded);
+
+        m_files.merge(PlaybackQueue(std::move(files)));
 
-        auto isValidFile = [](const Utils::FileInformation &f){ return Utils::isAudioFile(f.first) || Utils::isVideoFile(f.first); };
-        const auto validFilesCount = std::count_if(m_files.cbegin(), m_files.cend(), isValidFile);
+        const auto validFilesCount = m_files.playableCount();
 
         const auto isCasting = (m_process.state() == QProcess::Running);
         if(isCasting)
         {
-          const auto hasMoreFiles = (!m_files.empty() && validFilesCount > 0);
+          const auto hasMoreFiles = validFilesCount > 0;
 
           m_next->setEnabled(hasMoreFiles);
           m_icon->contextMenu()->actions().at(2)->setEnabled(hasMoreFiles);
@@ -1077,6 +1550,7 @@ void NowPlay::dragEnterEvent(QDragEnterEvent *e)
 void NowPlay::resetState()
 {
   setProgress(0);
+  m_gapTimer.invalidate();
 
   m_tabWidget->setEnabled(true);
   m_play->setText("Now Play!");
@@ -1093,7 +1567,7 @@ void NowPlay::onCopyFinished()
   if(thread)
   {
     QApplication::restoreOverrideCursor();
-    m_tabWidget->setEnabled(true);
+    setCopyWidgetsEnabled(true);
     m_play->setText(tr("Now Copy!"));
     setProgress(0);
 
@@ -1108,6 +1582,11 @@ void NowPlay::onCopyFinished()
       msgBox.setText(error);
       msgBox.setIcon(QMessageBox::Icon::Critical);
     }
+    else if(thread->isAborted())
+    {
+      msgBox.setText(tr("Copy stopped. It can be resumed later from the same destination directory."));
+      msgBox.setIcon(QMessageBox::Icon::Information);
+    }
     else
     {
       msgBox.setText(tr("Copy finished!"));
@@ -1121,6 +1600,84 @@ void NowPlay::onCopyFinished()
   }
 }
 
+//-----------------------------------------------------------------------------
+void NowPlay::startCopy(const std::vector<Utils::FileInformation> &directories, const std::vector<std::wstring> &destinations, const bool resume,
+                        const std::vector<Utils::FileInformation> &evicted, const std::vector<std::size_t> &assignments,
+                        const CopyThread::StreamingSelection &streaming)
+{
+  CopyThread::CopyConfiguration configuration;
+  configuration.threads    = m_copyThreads->value();
+  configuration.verify     = m_verify->isChecked();
+  configuration.resume     = resume;
+  configuration.bandwidth  = m_bandwidth->value() * MEGABYTE;
+  configuration.ioPriority = static_cast<CopyEngine::IOPriority>(m_ioPriority->currentIndex());
+  configuration.diskOrder  = m_diskOrder->isChecked();
+  configuration.durability = static_cast<CopyEngine::Durability>(m_durability->currentIndex());
+
+  m_thread = std::make_shared<CopyThread>(directories, destinations, configuration, this);
+  m_thread->setEvictedDirectories(evicted);
+  m_thread->setAssignments(assignments);
+  m_thread->setStreamingSelection(streaming);
+
+  connect(m_thread.get(), SIGNAL(log(const QString &)), this, SLOT(log(const QString &)));
+  connect(m_thread.get(), SIGNAL(progress(const int)), this, SLOT(setProgress(const int)));
+  connect(m_thread.get(), SIGNAL(throughput(const double, const int)), this, SLOT(onCopyThroughput(const double, const int)));
+  connect(m_thread.get(), SIGNAL(finished()), this, SLOT(onCopyFinished()));
+
+  setProgressRange(0, CopyThread::PROGRESS_MAXIMUM);
+
+  m_play->setText("Stop");
+  setCopyWidgetsEnabled(false);
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+
+  m_thread->start();
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::setCopyWidgetsEnabled(const bool enabled)
+{
+  // the bandwidth limit stays enabled to be changed while copying.
+  m_tabWidget->setTabEnabled(0, enabled);
+
+  const QList<QWidget *> widgets{m_destinationDir, m_browseDestination, m_addDestination, m_amount, m_units, m_copyThreads, m_verify,
+                                 m_diskOrder, m_sync, m_split, m_ioPriority, m_durability};
+  for(auto widget: widgets) widget->setEnabled(enabled);
+
+  m_keepPercent->setEnabled(enabled && m_sync->isChecked());
+  m_verify->setEnabled(enabled && CopyEngine::canVerify());
+  m_durability->setEnabled(enabled && CopyEngine::canFlush());
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onCastCommandSent(const QString &command, const double milliseconds, const bool fallback)
+{
+  const auto channel = fallback ? tr("castnow process") : tr("input");
+  log(tr("Command '%1' sent in %2 ms (%3).").arg(command).arg(milliseconds, 0, 'f', 1).arg(channel));
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onBandwidthChanged(int value)
+{
+  if(m_thread) m_thread->setBandwidthLimit(value * MEGABYTE);
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onCopyThroughput(const double bytesPerSecond, const int secondsLeft)
+{
+  const auto rate = QString::number(bytesPerSecond / MEGABYTE, 'f', 1);
+
+  QString eta = tr("unknown");
+  if(secondsLeft >= 0)
+  {
+    eta = QString("%1:%2:%3").arg(secondsLeft / 3600).arg((secondsLeft / 60) % 60, 2, 10, QChar('0')).arg(secondsLeft % 60, 2, 10, QChar('0'));
+  }
+
+  m_progress->setFormat(tr("%p% - %1 MB/s - %2 left").arg(rate).arg(eta));
+
+  const auto percent = m_progress->maximum() == 0 ? 0 : (100 * m_progress->value()) / m_progress->maximum();
+  m_icon->setToolTip(tr("Now Copy!\n%1% - %2 MB/s - %3 left").arg(percent).arg(rate).arg(eta));
+}
+
 //-----------------------------------------------------------------------------
 void NowPlay::setProgressRange(const int minimum, const int maximum)
 {
@@ -1154,30 +1711,103 @@ QIcon NowPlay::progressIcon()
 //-----------------------------------------------------------------------------
 void NowPlay::sendCommand(const QString &command)
 {
-  if(!command.isEmpty() && m_castnow->isChecked() && (m_process.state() == QProcess::Running))
+  if(!command.isEmpty() && m_castnow->isChecked())
   {
-    m_command.startDetached(m_castnowPath, QStringList{"--command", command,"--exit"});
-    m_command.waitForFinished(-1);
+    m_commands.send(command, m_castnowPath);
   }
 }
 
+//-----------------------------------------------------------------------------
+void NowPlay::refreshIndex(const std::filesystem::path &directory)
+{
+  if(m_indexThread) return;
+
+  const auto isCurrent = m_index.isValid() && m_index.baseDirectory() == directory;
+  if(isCurrent && m_indexTimer.isValid() && !m_indexTimer.hasExpired(INDEX_REFRESH_INTERVAL)) return;
+
+  m_indexThread = std::make_shared<IndexThread>(directory, m_scanThreads, this);
+
+  connect(m_indexThread.get(), SIGNAL(finished()), this, SLOT(onIndexFinished()));
+
+  m_indexThread->start(QThread::LowPriority);
+}
+
+//-----------------------------------------------------------------------------
+void NowPlay::onIndexFinished()
+{
+  auto thread = qobject_cast<IndexThread *>(sender());
+  if(thread)
+  {
+    if(!thread->isAborted() && thread->index().isValid())
+    {
+      m_index = thread->index();
+      m_indexTimer.start();
+
+      if(!m_index.save(LibraryIndex::indexFilename()))
+      {
+        log(tr("Unable to save the library index to: %1").arg(QDir::toNativeSeparators(LibraryIndex::indexFilename())));
+      }
+    }
+
+    m_indexThread = nullptr;
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::filesystem::path NowPlay::temporaryPlaylistFilename(const QString &name) const
+{
+  const QDir directory(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
+
+  // every launch gets its own file, a player started before may still be reading the previous one.
+  QTemporaryFile file(directory.absoluteFilePath(name));
+  file.setAutoRemove(false);
+  if(!file.open()) return directory.absoluteFilePath(QString(name).remove("-XXXXXX")).toStdWString();
+
+  return file.fileName().toStdWString();
+}
+
 //-----------------------------------------------------------------------------
 void NowPlay::playAudio()
 {
   if(!Utils::checkIfValidMusicPlayerLocation(m_musicPlayerPath)) return;
 
-  QStringList arguments;
+  // the playlists of the directory go to the player as they are, they can have streams the reader skips.
+  if(m_files.playlistCount() > 0)
+  {
+    QStringList arguments;
+    for(const auto &f: m_files.playlists()) arguments << QString::fromStdWString(f.first.wstring());
+
+    m_files.clear();
 
-  auto addToArguments = [&arguments](const Utils::FileInformation &f)
+    m_process.startDetached(m_musicPlayerPath, arguments);
+    return;
+  }
+
+  M3UPlaylist playlist(temporaryPlaylistFilename(AUDIO_PLAYLIST));
+  playlist.reserve(m_files.audioCount());
+
+  auto addAudio = [&playlist](const Utils::FileInformation &f)
   {
-    if(Utils::isPlaylistFile(f.first))
+    if(Utils::isAudioFile(f.first))
     {
-      arguments << QString::fromStdWString(f.first.wstring());
+      playlist.add(f.first);
     }
   };
-  std::for_each(m_files.cbegin(), m_files.cend(), addToArguments);
-
-  m_process.startDetached(m_musicPlayerPath, arguments);
+  std::for_each(m_files.media().cbegin(), m_files.media().cend(), addAudio);
 
   m_files.clear();
+
+  if(playlist.entries().empty())
+  {
+    log(tr("<b><font color =\"red\">No audio files to play!</font></b>"));
+    return;
+  }
+
+  if(!playlist.save())
+  {
+    log(tr("<b><font color =\"red\">Unable to write the playlist:</font></b> ") + QString::fromStdWString(playlist.filename().wstring()));
+    return;
+  }
+
+  m_process.startDetached(m_musicPlayerPath, QStringList{QString::fromStdWString(playlist.filename().wstring())});
 }
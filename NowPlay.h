@@ -22,11 +22,18 @@
 
 // Project
 #include <ui_NowPlayDialog.h>
+#include <CastCommandChannel.h>
+#include <CastOutputParser.h>
 #include <CopyThread.h>
+#include <IndexThread.h>
+#include <PrepareThread.h>
+#include <LibraryIndex.h>
+#include <PlaybackQueue.h>
 #include <Utils.h>
 
 // Qt
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QProcess>
 #include <QSystemTrayIcon>
 
@@ -92,11 +99,34 @@ class NowPlay
      */
     void castFile();
 
-    /** \brief Monitors the cast output to detect when it has finished.
+    /** \brief Passes the cast output to the parser.
      *
      */
     void onOuttputAvailable();
 
+    /** \brief Logs the gap between the last cast file and the current one, if measuring.
+     *
+     */
+    void onCastPlaying();
+
+    /** \brief Shows the playback position of the cast file in the progress bar.
+     * \param[in] seconds Playback position in seconds.
+     * \param[in] duration File duration in seconds.
+     *
+     */
+    void onCastPosition(const int seconds, const int duration);
+
+    /** \brief Stops the casting process when the cast file has finished, to cast the next one.
+     *
+     */
+    void onCastIdle();
+
+    /** \brief Logs the error and stops the casting process to cast the next file.
+     * \param[in] message Error message of the casting process.
+     *
+     */
+    void onCastError(const QString &message);
+
     /** \brief Updates the size label when the subtitle value changes.
      * \param[in] value Size (subtitle value * 10).
      *
@@ -130,6 +160,27 @@ class NowPlay
      */
     void onCopyFinished();
 
+    /** \brief Shows the copy speed and the estimated remaining time.
+     * \param[in] bytesPerSecond Copy speed in bytes per second.
+     * \param[in] secondsLeft Estimated seconds to finish or -1 if unknown.
+     *
+     */
+    void onCopyThroughput(const double bytesPerSecond, const int secondsLeft);
+
+    /** \brief Changes the bandwidth limit of the running copy.
+     * \param[in] value Bandwidth limit in megabytes per second, 0 for unlimited.
+     *
+     */
+    void onBandwidthChanged(int value);
+
+    /** \brief Logs the time the given cast command took to be delivered.
+     * \param[in] command Command text.
+     * \param[in] milliseconds Time from the key press to the delivery.
+     * \param[in] fallback True if sent with a castnow process and false if written to its input.
+     *
+     */
+    void onCastCommandSent(const QString &command, const double milliseconds, const bool fallback);
+
     /** \brief Sets the progress in the various widgets.
      * \param[in] value Progress value.
      *
@@ -143,6 +194,16 @@ class NowPlay
      */
     void setProgressRange(const int minimum, const int maximum);
 
+    /** \brief Replaces the library index with the refreshed one and stores it on disk.
+     *
+     */
+    void onIndexFinished();
+
+    /** \brief Casts the next file if it was waiting for the preparation that has finished.
+     *
+     */
+    void onFilePrepared();
+
   protected:
     virtual bool event(QEvent *e) override;
 
@@ -188,12 +249,13 @@ class NowPlay
      */
     bool callWinamp();
 
-    /** \brief Plays the list of files with the video player.
+    /** \brief Plays the list of files with the video player, passing them in a temporary playlist.
      *
      */
     void playVideos();
 
-    /** \brief Plays the music files with the music player.
+    /** \brief Plays the music files, or the entries of the playlists if any, with the music player
+     * passing them in a temporary playlist.
      *
      */
     void playAudio();
@@ -224,26 +286,81 @@ class NowPlay
      */
     QIcon progressIcon();
 
+    /** \brief Creates a new temporary playlist file and returns its path. Falls back to a fixed name if it
+     * can't be created.
+     * \param[in] name Playlist file name template, the XXXXXX part is replaced to make it unique.
+     *
+     */
+    std::filesystem::path temporaryPlaylistFilename(const QString &name) const;
+
     /** \brief Modifies the UI and resets the progress to 0.
      *
      */
     void resetState();
 
+    /** \brief Casts the next file of the queue once it has been prepared in the background, skipping the
+     * files that can't be read. Waits for the preparation without blocking if it hasn't finished.
+     *
+     */
+    void castNextFile();
+
+    /** \brief Starts the preparation of the given file in the background, if not already prepared. Only one
+     * file is prepared at a time, the next one is started when the running preparation finishes.
+     * \param[in] file Absolute file path.
+     *
+     */
+    void prepareFile(const std::filesystem::path &file);
+
     /** \brief Sets the given command to the currently casting process.
      * \param[in] command Command text.
      *
      */
     void sendCommand(const QString &command);
 
-    std::vector<Utils::FileInformation> m_files;           /** list of files being casted.                */
+    /** \brief Starts a background scan of the given directory to refresh the library index, if
+     * not already running or refreshed recently.
+     * \param[in] directory Base directory.
+     *
+     */
+    void refreshIndex(const std::filesystem::path &directory);
+
+    /** \brief Starts the copy thread.
+     * \param[in] directories Directories to copy.
+     * \param[in] destinations Destination directories.
+     * \param[in] resume True to resume the unfinished copy of the destinations and false otherwise.
+     * \param[in] evicted Destination directories to remove before copying.
+     * \param[in] assignments Destination of every directory when split between the destinations, empty to copy to all.
+     * \param[in] streaming Settings to select the directories while copying, instead of the given ones.
+     *
+     */
+    void startCopy(const std::vector<Utils::FileInformation> &directories, const std::vector<std::wstring> &destinations, const bool resume,
+                   const std::vector<Utils::FileInformation> &evicted = std::vector<Utils::FileInformation>(),
+                   const std::vector<std::size_t> &assignments = std::vector<std::size_t>(),
+                   const CopyThread::StreamingSelection &streaming = CopyThread::StreamingSelection());
+
+    /** \brief Enables or disables the copy settings widgets, except the bandwidth limit.
+     * \param[in] enabled True to enable and false to disable.
+     *
+     */
+    void setCopyWidgetsEnabled(const bool enabled);
+
+    PlaybackQueue                       m_files;           /** queue of files being played.               */
     QProcess                            m_process;         /** casting process.                           */
-    QProcess                            m_command;         /** process for casting commands.              */
+    CastCommandChannel                  m_commands;        /** commands to the casting process.           */
+    CastOutputParser                    m_parser;          /** parser of the casting process output.      */
     QString                             m_musicPlayerPath; /** Music player executable location.          */
     QString                             m_videoPlayerPath; /** Video player executable location.          */
     QString                             m_castnowPath;     /** Castnow script location.                   */
     bool                                m_continuous;      /** true for continuous play, false otherwise. */
+    unsigned int                        m_scanThreads;     /** number of scanning threads, 0 for auto.    */
     QSystemTrayIcon                    *m_icon;            /** application icon when minimized.           */
     std::shared_ptr<CopyThread>         m_thread;          /** Copy thread if copying or null.            */
+    LibraryIndex                        m_index;           /** Library index of the base directory.       */
+    std::shared_ptr<IndexThread>        m_indexThread;     /** Index thread if scanning or null.          */
+    QElapsedTimer                       m_indexTimer;      /** Time since the last index refresh.         */
+    std::shared_ptr<PrepareThread>      m_prepareThread;   /** preparation of the next file to cast.      */
+    bool                                m_castPending;     /** true if waiting for the preparation.       */
+    QElapsedTimer                       m_gapTimer;        /** Time since the last cast file ended.       */
 #ifdef __WIN64__
     QWinTaskbarButton                  *m_taskBarButton;   /** taskbar progress widget.                   */
 #endif
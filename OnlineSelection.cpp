@@ -0,0 +1,97 @@
+/*
+ File: OnlineSelection.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <OnlineSelection.h>
+
+// C++
+#include <chrono>
+
+const std::size_t MAX_REJECTED = 4096; // rejected directories kept to fill the remaining space at the end.
+
+//-----------------------------------------------------------------------------
+OnlineSelection::OnlineSelection(const unsigned long long size, const unsigned long long expected)
+: m_size{size}
+, m_expected{expected}
+, m_remaining{size}
+, m_offered{0}
+, m_generator(std::chrono::system_clock::now().time_since_epoch().count())
+{
+}
+
+//-----------------------------------------------------------------------------
+bool OnlineSelection::offer(Utils::FileInformation directory)
+{
+  const auto size = directory.second;
+  const auto unseen = m_expected > m_offered ? m_expected - m_offered : 0ULL;
+  m_offered += size;
+
+  if(size == 0 || size > m_remaining) return false;
+
+  // sequential sampling, the remaining space is spread over the candidates not seen yet. When the
+  // expected size is unknown or exceeded every candidate that fits is taken.
+  if(unseen > m_remaining)
+  {
+    std::uniform_real_distribution<double> distribution(0., 1.);
+    if(distribution(m_generator) * unseen >= m_remaining)
+    {
+      reject(std::move(directory));
+      return false;
+    }
+  }
+
+  m_remaining -= size;
+
+  // the kept directories that don't fit anymore can't be used to fill the space.
+  m_rejected.erase(m_rejected.upper_bound(Utils::FileInformation{std::filesystem::path(), m_remaining}), m_rejected.end());
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void OnlineSelection::reject(Utils::FileInformation directory)
+{
+  // the smallest ones are dropped first, the fill takes the biggest ones that fit and rarely gets to them.
+  if(m_rejected.size() >= MAX_REJECTED)
+  {
+    if(directory.second <= (*m_rejected.begin()).second) return;
+    m_rejected.erase(m_rejected.begin());
+  }
+
+  m_rejected.insert(std::move(directory));
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> OnlineSelection::finish()
+{
+  std::vector<Utils::FileInformation> selected;
+
+  // first fit decreasing with the directories that were skipped at random.
+  for(auto it = m_rejected.crbegin(); it != m_rejected.crend(); ++it)
+  {
+    if((*it).second > m_remaining) continue;
+
+    m_remaining -= (*it).second;
+    selected.push_back(*it);
+  }
+
+  m_rejected.clear();
+
+  return selected;
+}
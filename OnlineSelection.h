@@ -0,0 +1,94 @@
+/*
+ File: OnlineSelection.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ONLINESELECTION_H_
+#define ONLINESELECTION_H_
+
+// Project
+#include <Utils.h>
+
+// C++
+#include <random>
+#include <set>
+#include <vector>
+
+/** \class OnlineSelection
+ * \brief Selects random directories for a size limit while they are being scanned, without knowing
+ * the rest of them. Every offered directory that fits is selected with the probability that makes the
+ * selection spread over the whole expected candidates size, if known, or always otherwise. When the
+ * scan ends the remaining space is filled with the biggest rejected directories that still fit. Only
+ * a bounded number of the biggest rejected directories that fit the remaining space are kept.
+ *
+ */
+class OnlineSelection
+{
+  public:
+    /** \brief OnlineSelection class constructor.
+     * \param[in] size Size limit in bytes.
+     * \param[in] expected Expected sum of the sizes of all the candidates, 0 if unknown.
+     *
+     */
+    explicit OnlineSelection(const unsigned long long size, const unsigned long long expected = 0);
+
+    /** \brief Offers a directory to the selection. Returns true if selected and false otherwise.
+     * \param[in] directory Directory and its size.
+     *
+     */
+    bool offer(Utils::FileInformation directory);
+
+    /** \brief Ends the selection. Returns the rejected directories selected to fill the remaining space.
+     *
+     */
+    std::vector<Utils::FileInformation> finish();
+
+    /** \brief Returns the size limit not yet used by the selected directories.
+     *
+     */
+    unsigned long long remaining() const
+    { return m_remaining; }
+
+    /** \brief Returns the sum of the sizes of the selected directories.
+     *
+     */
+    unsigned long long selectedSize() const
+    { return m_size - m_remaining; }
+
+  private:
+    /** \brief Keeps the given rejected directory for the final fill if it's among the biggest ones.
+     * \param[in] directory Directory and its size.
+     *
+     */
+    void reject(Utils::FileInformation directory);
+
+    /** \brief Orders the directories by size. */
+    struct LessSize
+    {
+        bool operator()(const Utils::FileInformation &lhs, const Utils::FileInformation &rhs) const
+        { return lhs.second < rhs.second; }
+    };
+
+    const unsigned long long                          m_size;      /** size limit in bytes.                     */
+    const unsigned long long                          m_expected;  /** expected size of all the candidates.     */
+    unsigned long long                                m_remaining; /** size limit not used by the selection.    */
+    unsigned long long                                m_offered;   /** sum of the sizes of offered candidates.  */
+    std::multiset<Utils::FileInformation, LessSize>   m_rejected;  /** biggest rejected directories that fit.   */
+    std::default_random_engine                        m_generator; /** random number generator.                 */
+};
+
+#endif // ONLINESELECTION_H_
@@ -0,0 +1,84 @@
+/*
+ File: PlaybackQueue.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <PlaybackQueue.h>
+
+//-----------------------------------------------------------------------------
+PlaybackQueue::PlaybackQueue(std::vector<Utils::FileInformation> files)
+: PlaybackQueue()
+{
+  for(auto &file: files) append(std::move(file));
+}
+
+//-----------------------------------------------------------------------------
+bool PlaybackQueue::append(Utils::FileInformation file)
+{
+  switch(Utils::mediaKindFromExtension(file.first))
+  {
+    case Utils::MediaKind::Audio:
+      ++m_audio;
+      m_media.push_back(std::move(file));
+      break;
+    case Utils::MediaKind::Video:
+      ++m_video;
+      m_media.push_back(std::move(file));
+      break;
+    case Utils::MediaKind::Playlist:
+      m_playlists.push_back(std::move(file));
+      break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void PlaybackQueue::merge(PlaybackQueue &&other)
+{
+  m_media.splice(m_media.end(), other.m_media);
+  m_playlists.splice(m_playlists.end(), other.m_playlists);
+  m_audio += other.m_audio;
+  m_video += other.m_video;
+
+  other.m_audio = other.m_video = 0;
+}
+
+//-----------------------------------------------------------------------------
+bool PlaybackQueue::pop(Utils::FileInformation &file)
+{
+  if(m_media.empty()) return false;
+
+  file = std::move(m_media.front());
+  m_media.pop_front();
+
+  if(Utils::mediaKindFromExtension(file.first) == Utils::MediaKind::Audio) --m_audio;
+  else                                                                     --m_video;
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void PlaybackQueue::clear()
+{
+  m_media.clear();
+  m_playlists.clear();
+  m_audio = m_video = 0;
+}
@@ -0,0 +1,132 @@
+/*
+ File: PlaybackQueue.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLAYBACKQUEUE_H_
+#define PLAYBACKQUEUE_H_
+
+// Project
+#include <Utils.h>
+
+// C++
+#include <list>
+#include <vector>
+
+/** \class PlaybackQueue
+ * \brief Queue of the files to play. Audio and video files are kept in their order in one list and
+ * playlist files in another, with the number of files of every kind updated on every change, so getting
+ * the next file to play, adding a file and merging two queues take constant time.
+ *
+ */
+class PlaybackQueue
+{
+  public:
+    /** \brief PlaybackQueue class constructor. Creates an empty queue.
+     *
+     */
+    PlaybackQueue()
+    : m_audio{0}
+    , m_video{0}
+    {};
+
+    /** \brief PlaybackQueue class constructor.
+     * \param[in] files Files to queue, in order. Files that are not playable are ignored.
+     *
+     */
+    explicit PlaybackQueue(std::vector<Utils::FileInformation> files);
+
+    /** \brief Adds the given file at the end of the queue. Returns true if added and false if not playable.
+     * \param[in] file File to queue.
+     *
+     */
+    bool append(Utils::FileInformation file);
+
+    /** \brief Moves all the files of the given queue to the end of this one.
+     * \param[in] other Queue to merge, empty on return.
+     *
+     */
+    void merge(PlaybackQueue &&other);
+
+    /** \brief Removes the first audio or video file and returns it. Returns true on success and false
+     * if there are no audio or video files.
+     * \param[out] file First audio or video file.
+     *
+     */
+    bool pop(Utils::FileInformation &file);
+
+    /** \brief Removes all the files.
+     *
+     */
+    void clear();
+
+    /** \brief Returns true if the queue has no files and false otherwise.
+     *
+     */
+    bool empty() const
+    { return m_media.empty() && m_playlists.empty(); }
+
+    /** \brief Returns the number of files of the queue.
+     *
+     */
+    std::size_t size() const
+    { return m_media.size() + m_playlists.size(); }
+
+    /** \brief Returns the number of audio and video files.
+     *
+     */
+    std::size_t playableCount() const
+    { return m_media.size(); }
+
+    /** \brief Returns the number of audio files.
+     *
+     */
+    std::size_t audioCount() const
+    { return m_audio; }
+
+    /** \brief Returns the number of video files.
+     *
+     */
+    std::size_t videoCount() const
+    { return m_video; }
+
+    /** \brief Returns the number of playlist files.
+     *
+     */
+    std::size_t playlistCount() const
+    { return m_playlists.size(); }
+
+    /** \brief Returns the audio and video files in order.
+     *
+     */
+    const std::list<Utils::FileInformation> &media() const
+    { return m_media; }
+
+    /** \brief Returns the playlist files in order.
+     *
+     */
+    const std::list<Utils::FileInformation> &playlists() const
+    { return m_playlists; }
+
+  private:
+    std::list<Utils::FileInformation> m_media;     /** audio and video files in order. */
+    std::list<Utils::FileInformation> m_playlists; /** playlist files in order.        */
+    std::size_t                       m_audio;     /** number of audio files.          */
+    std::size_t                       m_video;     /** number of video files.          */
+};
+
+#endif // PLAYBACKQUEUE_H_
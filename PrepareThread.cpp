@@ -0,0 +1,36 @@
+/*
+ File: PrepareThread.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <PrepareThread.h>
+#include <Utils.h>
+
+//-----------------------------------------------------------------------------
+PrepareThread::PrepareThread(const std::filesystem::path &file, QObject *parent)
+: QThread(parent)
+, m_file{file}
+, m_ready{false}
+{
+}
+
+//-----------------------------------------------------------------------------
+void PrepareThread::run()
+{
+  m_ready = Utils::prepareFile(m_file);
+}
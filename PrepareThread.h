@@ -0,0 +1,73 @@
+/*
+ File: PrepareThread.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PREPARETHREAD_H_
+#define PREPARETHREAD_H_
+
+// Qt
+#include <QThread>
+
+// C++
+#include <atomic>
+#include <filesystem>
+
+/** \class PrepareThread
+ * \brief Checks that a file can be played and reads its beginning in the background, so a sleeping
+ * disk doesn't block the interface before casting it.
+ *
+ */
+class PrepareThread
+: public QThread
+{
+    Q_OBJECT
+  public:
+    /** \brief PrepareThread class constructor.
+     * \param[in] file Absolute path of the file to prepare.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit PrepareThread(const std::filesystem::path &file, QObject *parent = nullptr);
+
+    /** \brief PrepareThread class virtual destructor.
+     *
+     */
+    virtual ~PrepareThread()
+    {};
+
+    /** \brief Returns the path of the prepared file.
+     *
+     */
+    const std::filesystem::path &file() const
+    { return m_file; }
+
+    /** \brief Returns true if the file can be played and false otherwise, only valid after the thread has finished.
+     *
+     */
+    bool isReady() const
+    { return m_ready; }
+
+  protected:
+    virtual void run();
+
+  private:
+    const std::filesystem::path m_file;  /** file to prepare.                */
+    std::atomic<bool>           m_ready; /** true if the file can be played. */
+};
+
+#endif // PREPARETHREAD_H_
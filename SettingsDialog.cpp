@@ -38,6 +38,7 @@ SettingsDialog::SettingsDialog(const PlayConfiguration &config, QWidget *parent)
   m_castnowPath->setText(QDir::toNativeSeparators(config.castnowPath));
   m_videoPlayerPath->setText(QDir::toNativeSeparators(config.videoPlayerPath));
   m_continuousPlay->setChecked(config.continuous);
+  m_scanThreads->setValue(static_cast<int>(config.scanThreads));
 
   connect(m_musicPlayerBrowse, SIGNAL(pressed()), this, SLOT(onBrowseButtonClicked()));
   connect(m_videoPlayerBrowse, SIGNAL(pressed()), this, SLOT(onBrowseButtonClicked()));
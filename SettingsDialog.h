@@ -43,12 +43,13 @@ class SettingsDialog
      */
     struct PlayConfiguration
     {
-        QString musicPlayerPath; /** Music player path.                          */
-        QString videoPlayerPath; /** Video player path.                          */
-        QString castnowPath;     /** castnow executable path.                    */
-        bool    continuous;      /** true if continuous play or false otherwise. */
+        QString      musicPlayerPath; /** Music player path.                           */
+        QString      videoPlayerPath; /** Video player path.                           */
+        QString      castnowPath;     /** castnow executable path.                     */
+        bool         continuous;      /** true if continuous play or false otherwise.  */
+        unsigned int scanThreads;     /** number of scanning threads, 0 for automatic. */
 
-        PlayConfiguration(): continuous{false} {};
+        PlayConfiguration(): continuous{false}, scanThreads{0} {};
     };
 
     /** \brief SettingsDialog class constructor.
@@ -88,6 +89,12 @@ class SettingsDialog
     const bool getContinuousPlay() const
     { return m_continuousPlay->isChecked(); }
 
+    /** \brief Returns the number of threads to scan the base directory, 0 for automatic.
+     *
+     */
+    const unsigned int getScanThreads() const
+    { return static_cast<unsigned int>(m_scanThreads->value()); }
+
   private slots:
     /** \brief Browses for the given executable/script depending on the signal sender.
      *
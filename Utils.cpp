@@ -25,53 +25,429 @@
 #include <random>
 #include <chrono>
 #include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
 
 // Qt
 #include <QFileInfo>
 
+#ifdef __linux__
+// Linux
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+#ifdef __WIN64__
+// Windows
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace
+{
+  /** \struct MediaExtension
+   * \brief Extension of a playable file and its media kind.
+   *
+   */
+  struct MediaExtension
+  {
+      const char       *extension; /** lower case extension without dot. */
+      Utils::MediaKind  kind;      /** media kind of the extension.       */
+  };
+
+  /** list of playable extensions, the lookup table is built from it at compile time. */
+  constexpr MediaExtension MEDIA_EXTENSIONS[] = { { "mp3",  Utils::MediaKind::Audio    },
+                                                  { "m4a",  Utils::MediaKind::Audio    },
+                                                  { "flac", Utils::MediaKind::Audio    },
+                                                  { "ogg",  Utils::MediaKind::Audio    },
+                                                  { "opus", Utils::MediaKind::Audio    },
+                                                  { "mp4",  Utils::MediaKind::Video    },
+                                                  { "mkv",  Utils::MediaKind::Video    },
+                                                  { "webm", Utils::MediaKind::Video    },
+                                                  { "m4v",  Utils::MediaKind::Video    },
+                                                  { "m3u",  Utils::MediaKind::Playlist },
+                                                  { "m3u8", Utils::MediaKind::Playlist } };
+
+  constexpr std::size_t EXTENSIONS_TABLE_SIZE = 32; /** power of two greater than the number of extensions. */
+  constexpr std::size_t MAX_EXTENSION_LENGTH  = 8;  /** longer extensions are never playable.                */
+
+  /** \brief Returns the lower case value of the given ASCII character.
+   * \param[in] c Character.
+   *
+   */
+  template<typename Char> constexpr Char asciiLower(const Char c)
+  {
+    return (c >= 'A' && c <= 'Z') ? static_cast<Char>(c - 'A' + 'a') : c;
+  }
+
+  /** \brief Returns the seeded FNV-1a hash of the given extension, case insensitive.
+   * \param[in] extension Extension characters without the dot.
+   * \param[in] length Extension length.
+   * \param[in] seed Hash seed.
+   *
+   */
+  template<typename Char> constexpr std::uint32_t extensionHash(const Char *extension, const std::size_t length, const std::uint32_t seed)
+  {
+    std::uint32_t hash = 2166136261U ^ seed;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+      hash ^= static_cast<std::uint32_t>(asciiLower(extension[i])) & 0xFF;
+      hash *= 16777619U;
+    }
+
+    return hash;
+  }
+
+  /** \brief Returns the length of the given null terminated string.
+   * \param[in] text Text string.
+   *
+   */
+  constexpr std::size_t textLength(const char *text)
+  {
+    std::size_t length = 0;
+    while(text[length] != 0) ++length;
+    return length;
+  }
+
+  /** \brief Returns the slot of the given extension in the lookup table.
+   * \param[in] extension Extension characters without the dot.
+   * \param[in] length Extension length.
+   * \param[in] seed Hash seed.
+   *
+   */
+  template<typename Char> constexpr std::size_t extensionSlot(const Char *extension, const std::size_t length, const std::uint32_t seed)
+  {
+    const auto hash = extensionHash(extension, length, seed);
+    return (hash ^ (hash >> 16)) & (EXTENSIONS_TABLE_SIZE - 1);
+  }
+
+  /** \brief Returns the first seed that maps every extension to a different slot of the table.
+   *
+   */
+  constexpr std::uint32_t perfectHashSeed()
+  {
+    for(std::uint32_t seed = 0; seed < 100000; ++seed)
+    {
+      bool used[EXTENSIONS_TABLE_SIZE] = {};
+      bool collision = false;
+
+      for(const auto &media: MEDIA_EXTENSIONS)
+      {
+        if(textLength(media.extension) > MAX_EXTENSION_LENGTH) return 0xFFFFFFFF;
+
+        const auto slot = extensionSlot(media.extension, textLength(media.extension), seed);
+        collision |= used[slot];
+        used[slot] = true;
+      }
+
+      if(!collision) return seed;
+    }
+
+    return 0xFFFFFFFF;
+  }
+
+  constexpr std::uint32_t EXTENSIONS_SEED = perfectHashSeed();
+  static_assert(EXTENSIONS_SEED != 0xFFFFFFFF, "Extension longer than MAX_EXTENSION_LENGTH or no perfect hash seed, increase the table size.");
+
+  /** \struct ExtensionsTable
+   * \brief Perfect hash lookup table of the playable extensions.
+   *
+   */
+  struct ExtensionsTable
+  {
+      const char       *extension[EXTENSIONS_TABLE_SIZE] = {}; /** extension of the slot or null.    */
+      std::size_t       length[EXTENSIONS_TABLE_SIZE]    = {}; /** length of the slot's extension.   */
+      Utils::MediaKind  kind[EXTENSIONS_TABLE_SIZE]      = {}; /** media kind of the slot's extension. */
+  };
+
+  /** \brief Returns the lookup table of the playable extensions.
+   *
+   */
+  constexpr ExtensionsTable buildExtensionsTable()
+  {
+    ExtensionsTable table;
+
+    for(const auto &media: MEDIA_EXTENSIONS)
+    {
+      const auto length = textLength(media.extension);
+      const auto slot = extensionSlot(media.extension, length, EXTENSIONS_SEED);
+      table.extension[slot] = media.extension;
+      table.length[slot]    = length;
+      table.kind[slot]      = media.kind;
+    }
+
+    return table;
+  }
+
+  constexpr ExtensionsTable EXTENSIONS_TABLE = buildExtensionsTable();
+
+  /** \brief Returns the media kind of the given file name characters.
+   * \param[in] name File name or path characters.
+   * \param[in] size Number of characters.
+   *
+   */
+  template<typename Char> Utils::MediaKind mediaKindFromName(const Char *name, const std::size_t size)
+  {
+    // find the extension of the last path element, files starting with a dot have no extension.
+    std::size_t dot = size;
+    for(std::size_t i = size; i > 0; --i)
+    {
+      const auto c = name[i - 1];
+      if(c == '/' || c == '\\') break;
+      if(c == '.')
+      {
+        const bool isFirst = (i == 1) || name[i - 2] == '/' || name[i - 2] == '\\';
+        if(!isFirst) dot = i;
+        break;
+      }
+    }
+
+    const auto length = size - dot;
+    if(length == 0 || length > MAX_EXTENSION_LENGTH) return Utils::MediaKind::None;
+
+    const auto extension = name + dot;
+    const auto slot = extensionSlot(extension, length, EXTENSIONS_SEED);
+    if(!EXTENSIONS_TABLE.extension[slot] || EXTENSIONS_TABLE.length[slot] != length) return Utils::MediaKind::None;
+
+    for(std::size_t i = 0; i < length; ++i)
+    {
+      if(asciiLower(extension[i]) != static_cast<Char>(EXTENSIONS_TABLE.extension[slot][i])) return Utils::MediaKind::None;
+    }
+
+    return EXTENSIONS_TABLE.kind[slot];
+  }
+}
+
 //-----------------------------------------------------------------------------
-bool Utils::isAudioFile(const std::filesystem::path &path)
+Utils::MediaKind Utils::mediaKindFromExtension(const std::filesystem::path &path)
 {
-  auto extension = path.extension().string();
-  toLower(extension);
+  const auto &name = path.native();
 
-  return std::filesystem::is_regular_file(path) && (extension.compare(".mp3") == 0 || extension.compare(".m4a") == 0);
+  return mediaKindFromName(name.c_str(), name.size());
 }
 
 //-----------------------------------------------------------------------------
-bool Utils::isPlaylistFile(const std::filesystem::path &path)
+Utils::MediaKind Utils::mediaKind(const std::filesystem::directory_entry &entry)
 {
-  auto extension = path.extension().string();
-  toLower(extension);
+  const auto kind = mediaKindFromExtension(entry.path());
+  if(kind == MediaKind::None) return kind;
 
-  return std::filesystem::is_regular_file(path) && (extension.compare(".m3u") == 0 || extension.compare(".m3u8") == 0);
+  return entry.is_regular_file() ? kind : MediaKind::None;
+}
+
+//-----------------------------------------------------------------------------
+bool Utils::isAudioFile(const std::filesystem::path &path)
+{
+  return mediaKindFromExtension(path) == MediaKind::Audio && std::filesystem::is_regular_file(path);
+}
+
+//-----------------------------------------------------------------------------
+bool Utils::isPlaylistFile(const std::filesystem::path &path)
+{
+  return mediaKindFromExtension(path) == MediaKind::Playlist && std::filesystem::is_regular_file(path);
 }
 
 //-----------------------------------------------------------------------------
 bool Utils::isVideoFile(const std::filesystem::path &path)
 {
-  auto extension = path.extension().string();
-  toLower(extension);
+  return mediaKindFromExtension(path) == MediaKind::Video && std::filesystem::is_regular_file(path);
+}
+
+namespace
+{
+  // copy overhead estimates, on the high side of the common file systems. FAT long names take 32 bytes
+  // every 13 characters, so the names are counted several times.
+  constexpr unsigned long long DIRECTORY_ENTRY_SIZE = 32; /** bytes of a directory entry besides the name.         */
+  constexpr unsigned long long NAME_ENTRY_FACTOR    = 3;  /** directory entry bytes per name character.            */
+  constexpr unsigned long long MANIFEST_LINE_SIZE   = 40; /** bytes of a manifest line besides the name.           */
+  constexpr unsigned long long JOURNAL_LINE_SIZE    = 48; /** bytes of the journal lines of a directory but the path. */
+
+  /** \struct ScanQueue
+   * \brief Directories pending to be scanned by a thread of the parallel scanner.
+   *
+   */
+  struct ScanQueue
+  {
+      std::mutex                        mutex;       /** protects the queue.                              */
+      std::deque<std::filesystem::path> directories; /** owner pops from the back, thieves from the front. */
+  };
+
+  /** \brief Returns the number of scanning threads for the given value.
+   * \param[in] threads Number of threads, 0 to use one per core.
+   *
+   */
+  unsigned int scanThreads(const unsigned int threads)
+  {
+    if(threads != 0) return threads;
 
-  return std::filesystem::is_regular_file(path) &&
-         (extension.compare(".mp4") == 0 || extension.compare(".mkv") == 0 || extension.compare(".webm") == 0);
+    return std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  /** \brief Parallel version of Utils::scanDirectoryTree(). Every thread scans one directory at a time
+   * and queues its sub-directories, idle threads steal the oldest directories of the others so whole
+   * sub-trees move between threads. The results are merged and sorted so the output is deterministic.
+   * \param[in] directory Absolute path of the directory to scan.
+   * \param[in] threads Number of scanning threads.
+   * \param[in] abort Optional flag to stop the scan.
+   *
+   */
+  std::vector<Utils::DirectoryInformation> scanDirectoryTreeParallel(const std::filesystem::path &directory, const unsigned int threads, const std::atomic<bool> *abort)
+  {
+    std::vector<ScanQueue> queues(threads);
+    std::vector<std::vector<Utils::DirectoryInformation>> results(threads);
+    std::atomic<std::size_t> pending{1};
+    std::atomic<std::size_t> queued{1};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+
+    queues.front().directories.push_back(directory);
+
+    // the idle mutex is taken before notifying so a thread can't miss the change between its check and its wait.
+    auto notify = [&idleMutex, &idle](const bool all)
+    {
+      { std::lock_guard<std::mutex> lock(idleMutex); }
+      if(all) idle.notify_all(); else idle.notify_one();
+    };
+
+    auto takeDirectory = [&queues, &queued, threads](const unsigned int id, std::filesystem::path &dir)
+    {
+      {
+        auto &own = queues.at(id);
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.directories.empty())
+        {
+          dir = std::move(own.directories.back());
+          own.directories.pop_back();
+          --queued;
+          return true;
+        }
+      }
+
+      for(unsigned int i = 1; i < threads; ++i)
+      {
+        auto &victim = queues.at((id + i) % threads);
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.directories.empty())
+        {
+          dir = std::move(victim.directories.front());
+          victim.directories.pop_front();
+          --queued;
+          return true;
+        }
+      }
+
+      return false;
+    };
+
+    auto worker = [&](const unsigned int id)
+    {
+      std::filesystem::path current;
+      const auto options = std::filesystem::directory_options::skip_permission_denied;
+
+      while(pending > 0 && !failed && !(abort && *abort))
+      {
+        if(!takeDirectory(id, current))
+        {
+          // the abort flag doesn't notify, so the wait is limited.
+          std::unique_lock<std::mutex> lock(idleMutex);
+          idle.wait_for(lock, std::chrono::milliseconds(50), [&]() { return queued > 0 || pending == 0 || failed || (abort && *abort); });
+          continue;
+        }
+
+        try
+        {
+          Utils::DirectoryInformation information{current, {}};
+
+          for(const auto &entry: std::filesystem::directory_iterator{current, options})
+          {
+            const auto &name = entry.path();
+            if(entry.is_directory())
+            {
+              // symbolic links to directories are listed but not followed, like the serial scanner.
+              if(entry.is_symlink())
+              {
+                results.at(id).push_back(Utils::DirectoryInformation{name, {}});
+                continue;
+              }
+
+              ++pending;
+              {
+                auto &own = queues.at(id);
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.directories.push_back(name);
+                ++queued;
+              }
+              notify(false);
+              continue;
+            }
+
+            if(Utils::mediaKind(entry) != Utils::MediaKind::None)
+            {
+              information.files.emplace_back(name, entry.file_size());
+            }
+          }
+
+          results.at(id).push_back(std::move(information));
+        }
+        catch(...)
+        {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if(!error) error = std::current_exception();
+          failed = true;
+        }
+
+        if(--pending == 0 || failed) notify(true);
+      }
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned int i = 1; i < threads; ++i) workers.emplace_back(worker, i);
+    worker(0);
+    for(auto &thread: workers) thread.join();
+
+    if(error) std::rethrow_exception(error);
+    if(abort && *abort) return {};
+
+    std::vector<Utils::DirectoryInformation> directories;
+    for(auto &result: results) std::move(result.begin(), result.end(), std::back_inserter(directories));
+
+    return directories;
+  }
 }
 
 //-----------------------------------------------------------------------------
-std::vector<Utils::FileInformation> Utils::getPlayableFiles(const std::filesystem::path &directory)
+std::vector<Utils::FileInformation> Utils::getPlayableFiles(const std::filesystem::path &directory, unsigned int threads)
 {
   std::vector<FileInformation> files;
 
+  if(scanThreads(threads) > 1)
+  {
+    auto tree = scanDirectoryTree(directory, threads);
+    for(auto &dir: tree) std::move(dir.files.begin(), dir.files.end(), std::back_inserter(files));
+
+    std::sort(files.begin(), files.end(), lessThan);
+
+    return files;
+  }
+
   if(!directory.empty() && std::filesystem::is_directory(directory))
   {
-    for(const auto &it: std::filesystem::recursive_directory_iterator{directory})
+    const auto options = std::filesystem::directory_options::skip_permission_denied;
+    for(const auto &it: std::filesystem::recursive_directory_iterator{directory, options})
     {
-      const auto name = it.path();
-      if(name.filename().string().compare(".") == 0 || name.filename().string().compare("..") == 0) continue;
-
-      if(Utils::isAudioFile(name) || Utils::isVideoFile(name) || Utils::isPlaylistFile(name))
+      if(Utils::mediaKind(it) != MediaKind::None)
       {
-        files.emplace_back(name, std::filesystem::file_size(name));
+        files.emplace_back(it.path(), it.file_size());
       }
     }
   }
@@ -82,115 +458,407 @@ std::vector<Utils::FileInformation> Utils::getPlayableFiles(const std::filesyste
 }
 
 //-----------------------------------------------------------------------------
-std::vector<Utils::FileInformation> Utils::getSubdirectories(const std::filesystem::path &directory, bool readSize)
+unsigned long long Utils::Capacity::directorySpace(const unsigned long long files, const unsigned long long namesLength,
+                                                   const unsigned long long pathLength) const
+{
+  // directory entries are a small header plus the name, including the dot entries and the manifest, the
+  // manifest a line per file. The journal is a single file, so its lines are not rounded to blocks.
+  const auto entries  = (files + 3) * DIRECTORY_ENTRY_SIZE + NAME_ENTRY_FACTOR * namesLength;
+  const auto manifest = files * MANIFEST_LINE_SIZE + namesLength;
+  const auto journal  = JOURNAL_LINE_SIZE + pathLength;
+
+  return fileSpace(entries) + fileSpace(manifest) + journal;
+}
+
+//-----------------------------------------------------------------------------
+bool Utils::getCapacity(const std::filesystem::path &path, Capacity &capacity)
+{
+#ifdef __linux__
+  struct statvfs information;
+  if(::statvfs(path.c_str(), &information) != 0) return false;
+
+  const unsigned long long blockSize = information.f_frsize != 0 ? information.f_frsize : information.f_bsize;
+  capacity.blockSize = std::max(1ULL, blockSize);
+  capacity.available = information.f_bavail * blockSize;
+#elif defined(__WIN64__)
+  // the cluster size is queried on the root of the volume, the available space honors the user quotas.
+  WCHAR root[MAX_PATH];
+  DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+  ULARGE_INTEGER available;
+  if(!::GetVolumePathNameW(path.c_str(), root, MAX_PATH) ||
+     !::GetDiskFreeSpaceW(root, &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters) ||
+     !::GetDiskFreeSpaceExW(path.c_str(), &available, nullptr, nullptr)) return false;
+
+  capacity.blockSize = std::max(1ULL, static_cast<unsigned long long>(sectorsPerCluster) * bytesPerSector);
+  capacity.available = available.QuadPart;
+#else
+  std::error_code error;
+  const auto space = std::filesystem::space(path, error);
+  if(error) return false;
+
+  capacity.available = space.available;
+#endif
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> Utils::copySpaces(const std::vector<DirectoryInformation> &tree, const Capacity &capacity, const std::size_t first)
 {
   std::vector<FileInformation> directories;
+  if(tree.size() <= first) return directories;
 
-  if(!directory.empty() && std::filesystem::is_directory(directory))
+  // space, number of files and names length of every sub-tree, added up to the ancestors as the sizes.
+  std::vector<unsigned long long> space(tree.size(), 0), files(tree.size(), 0), names(tree.size(), 0);
+  for(std::size_t i = 0; i < tree.size(); ++i)
   {
-    for(const auto &it: std::filesystem::recursive_directory_iterator{directory})
+    for(const auto &file: tree.at(i).files)
     {
-      const auto name = it.path();
-      if(name.filename().string().compare(".") == 0 || name.filename().string().compare("..") == 0) continue;
+      space.at(i) += capacity.fileSpace(file.second);
+      names.at(i) += file.first.filename().native().size();
+    }
+    files.at(i) = tree.at(i).files.size();
+  }
 
-      if(std::filesystem::is_directory(it))
-      {
-        unsigned long long size = 0L;
-        if(readSize)
-        {
-          auto files = getPlayableFiles(it.path().string());
+  for(std::size_t i = tree.size(); i-- > 1;)
+  {
+    const auto parent = tree.at(i).parent;
+    if(parent == i) continue;
 
-          auto addOp = [](const unsigned long long &s, const FileInformation &f)
-          {
-            return s + f.second;
-          };
-          size = std::accumulate(files.cbegin(), files.cend(), 0L, addOp);
-        }
+    space.at(parent) += space.at(i);
+    files.at(parent) += files.at(i);
+    names.at(parent) += names.at(i);
+  }
+
+  directories.reserve(tree.size() - first);
+  for(std::size_t i = first; i < tree.size(); ++i)
+  {
+    const auto overhead = capacity.directorySpace(files.at(i), names.at(i), tree.at(i).path.native().size());
+    directories.emplace_back(tree.at(i).path, space.at(i) + overhead);
+  }
 
-        directories.emplace_back(it.path(), size);
+  return directories;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> Utils::getSubdirectories(const std::filesystem::path &directory, const Capacity &capacity, unsigned int threads)
+{
+  return copySpaces(scanDirectoryTree(directory, threads), capacity, 1);
+}
+
+//-----------------------------------------------------------------------------
+bool Utils::streamSubdirectories(const std::filesystem::path &directory, const Capacity &capacity, const SubdirectoriesCallback &callback,
+                                 unsigned int threads, const std::atomic<bool> *abort)
+{
+  if(directory.empty() || !std::filesystem::is_directory(directory)) return true;
+
+  // the immediate sub-directories are scanned in random order, so every batch is a random part of the tree.
+  std::vector<std::filesystem::path> children;
+  const auto options = std::filesystem::directory_options::skip_permission_denied;
+  for(const auto &entry: std::filesystem::directory_iterator{directory, options})
+  {
+    if(entry.is_directory() && !entry.is_symlink()) children.push_back(entry.path());
+  }
+
+  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+  std::default_random_engine generator(seed);
+  std::shuffle(children.begin(), children.end(), generator);
+
+  for(const auto &child: children)
+  {
+    if(abort && *abort) return false;
+
+    auto batch = copySpaces(scanDirectoryTree(child, threads, abort), capacity, 0);
+    if(abort && *abort) return false;
+
+    std::shuffle(batch.begin(), batch.end(), generator);
+    if(!callback(std::move(batch))) return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::DirectoryInformation> Utils::scanDirectoryTree(const std::filesystem::path &directory, unsigned int threads, const std::atomic<bool> *abort)
+{
+  std::vector<DirectoryInformation> directories;
+
+  if(directory.empty() || !std::filesystem::is_directory(directory)) return directories;
+
+  // a trailing separator would leave an empty last component that no sub-directory shares.
+  const auto base = normalizedDirectory(directory);
+  if(base != directory) return scanDirectoryTree(base, threads, abort);
+
+  if(scanThreads(threads) > 1)
+  {
+    directories = scanDirectoryTreeParallel(directory, scanThreads(threads), abort);
+    if(directories.empty()) return directories;
+  }
+  else
+  {
+    directories.push_back(DirectoryInformation{directory, {}});
+
+    // index in directories of the parent of the entries at each depth.
+    std::vector<std::size_t> parents{0};
+
+    const auto options = std::filesystem::directory_options::skip_permission_denied;
+    for(auto it = std::filesystem::recursive_directory_iterator{directory, options}; it != std::filesystem::recursive_directory_iterator(); ++it)
+    {
+      if(abort && *abort) return {};
+
+      const auto depth = static_cast<std::size_t>(it.depth());
+      parents.resize(depth + 1);
+
+      const auto &name = it->path();
+      if(it->is_directory())
+      {
+        directories.push_back(DirectoryInformation{name, {}});
+        parents.push_back(directories.size() - 1);
+        continue;
+      }
+
+      if(Utils::mediaKind(*it) != MediaKind::None)
+      {
+        directories.at(parents.at(depth)).files.emplace_back(name, it->file_size());
       }
     }
   }
 
-  std::sort(directories.begin(), directories.end(), lessThan);
+  auto lessThanDirectory = [](const DirectoryInformation &lhs, const DirectoryInformation &rhs) { return lhs.path < rhs.path; };
+  std::sort(directories.begin(), directories.end(), lessThanDirectory);
+
+  for(auto &dir: directories) std::sort(dir.files.begin(), dir.files.end(), lessThan);
+
+  linkDirectoryTree(directories);
 
   return directories;
 }
 
 //-----------------------------------------------------------------------------
-std::vector<Utils::FileInformation> Utils::getCopyDirectories(std::vector<Utils::FileInformation> &dirs, const unsigned long long size)
+std::filesystem::path Utils::normalizedDirectory(const std::filesystem::path &directory)
+{
+  auto normal = directory.lexically_normal();
+  if(!normal.has_filename() && normal.has_relative_path()) normal = normal.parent_path();
+
+  return normal;
+}
+
+//-----------------------------------------------------------------------------
+void Utils::linkDirectoryTree(std::vector<DirectoryInformation> &directories)
+{
+  // the list is sorted by path, so the ancestors of a directory are always on the stack.
+  std::vector<std::size_t> ancestors;
+
+  // the empty last component of a path with a trailing separator isn't compared.
+  auto isAncestor = [](const std::filesystem::path &ancestor, const std::filesystem::path &path)
+  {
+    auto last = ancestor.end();
+    if(!ancestor.has_filename() && ancestor.has_relative_path()) --last;
+
+    return std::mismatch(ancestor.begin(), last, path.begin(), path.end()).first == last;
+  };
+
+  for(std::size_t i = 0; i < directories.size(); ++i)
+  {
+    auto &directory = directories.at(i);
+
+    while(!ancestors.empty() && !isAncestor(directories.at(ancestors.back()).path, directory.path))
+    {
+      ancestors.pop_back();
+    }
+
+    directory.parent = ancestors.empty() ? i : ancestors.back();
+
+    ancestors.push_back(i);
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::filesystem::path Utils::getRandomSubdirectory(const std::filesystem::path &directory, std::size_t &count)
+{
+  std::filesystem::path selected;
+  count = 0;
+
+  if(directory.empty() || !std::filesystem::is_directory(directory)) return selected;
+
+  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+  std::default_random_engine generator(seed);
+
+  const auto options = std::filesystem::directory_options::skip_permission_denied;
+  for(const auto &it: std::filesystem::recursive_directory_iterator{directory, options})
+  {
+    if(!it.is_directory()) continue;
+
+    ++count;
+
+    // the n-th directory replaces the selected one with probability 1/n.
+    std::uniform_int_distribution<std::size_t> distribution(1, count);
+    if(distribution(generator) == 1) selected = it.path();
+  }
+
+  return selected;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<Utils::FileInformation> Utils::getCopyDirectories(std::vector<Utils::FileInformation> &dirs, const unsigned long long size,
+                                                              const double tolerance, const unsigned int iterations)
+{
+  return getCopyDirectories(dirs, std::vector<unsigned long long>(1, size), tolerance, iterations).front();
+}
+
+//-----------------------------------------------------------------------------
+std::vector<std::vector<Utils::FileInformation>> Utils::getCopyDirectories(std::vector<Utils::FileInformation> &dirs, const std::vector<unsigned long long> &sizes,
+                                                                           const double tolerance, const unsigned int iterations)
 {
-  std::vector<FileInformation> selectedDirs;
+  std::vector<std::vector<FileInformation>> selectedDirs(sizes.size());
+  std::vector<FileInformation> rejectedDirs;
 
   unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
   std::default_random_engine generator(seed);
 
-  bool finished = false;
-  unsigned long long remaining = size;
+  std::vector<unsigned long long> remaining = sizes;
 
-  while(!finished)
+  // random draws, the drawn directory is swapped with the last one and removed in constant time. Every
+  // directory goes to the destination with the least remaining space where it fits (best fit), leaving
+  // the biggest gaps for the bigger directories.
+  while(!dirs.empty())
   {
-    std::uniform_int_distribution<int> distribution(1, dirs.size());
-    const int roll = distribution(generator);
-    const auto selectedPath = dirs.at(roll-1);
+    std::uniform_int_distribution<std::size_t> distribution(0, dirs.size() - 1);
+    const auto roll = distribution(generator);
+
+    std::swap(dirs.at(roll), dirs.back());
+    auto selectedPath = std::move(dirs.back());
+    dirs.pop_back();
+
+    if(selectedPath.second == 0) continue;
 
-    if(selectedPath.second == 0)
+    auto best = sizes.size();
+    for(std::size_t i = 0; i < sizes.size(); ++i)
     {
-      dirs.erase(dirs.begin() + roll-1);
-      continue;
+      if(selectedPath.second <= remaining.at(i) && (best == sizes.size() || remaining.at(i) < remaining.at(best))) best = i;
     }
 
-    if(dirs.empty() || selectedPath.second > remaining)
+    if(best != sizes.size())
     {
-      finished = true;
-
-      auto computeMaximumFit = [&remaining, &selectedDirs](const FileInformation &f)
-      {
-        if(f.second < remaining)
-        {
-          remaining -= f.second;
-          selectedDirs.push_back(f);
-        }
-      };
-      std::for_each(dirs.begin(), dirs.end(), computeMaximumFit);
+      remaining.at(best) -= selectedPath.second;
+      selectedDirs.at(best).push_back(std::move(selectedPath));
     }
     else
     {
-      selectedDirs.push_back(selectedPath);
-      remaining -= selectedPath.second;
-      dirs.erase(dirs.begin() + roll-1);
+      rejectedDirs.push_back(std::move(selectedPath));
     }
   }
 
-  std::sort(selectedDirs.begin(), selectedDirs.end(), Utils::lessThan);
+  // exchange selected directories with the biggest unselected one that still fits until the selection
+  // is within the tolerance, every exchange reduces the remaining space. Destinations are filled in turn
+  // from the same unselected directories.
+  auto lessThanSize = [](const FileInformation &lhs, const FileInformation &rhs)
+  {
+    return (lhs.second != rhs.second) ? lhs.second < rhs.second : lhs.first < rhs.first;
+  };
+  std::multiset<FileInformation, decltype(lessThanSize)> candidates(rejectedDirs.cbegin(), rejectedDirs.cend(), lessThanSize);
+  rejectedDirs.clear();
+
+  for(std::size_t b = 0; b < sizes.size(); ++b)
+  {
+    auto &selected = selectedDirs.at(b);
+    auto &left = remaining.at(b);
+    const auto slack = static_cast<unsigned long long>(sizes.at(b) * std::max(0., tolerance));
+
+    if(left <= slack || selected.empty() || candidates.empty()) continue;
+
+    std::vector<std::size_t> order(selected.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    unsigned int attempts = 0;
+    bool improved = true;
+    while(improved && left > slack && attempts < iterations)
+    {
+      improved = false;
+      std::shuffle(order.begin(), order.end(), generator);
+
+      for(std::size_t i = 0; i < order.size() && left > slack && attempts < iterations; ++i, ++attempts)
+      {
+        auto &current = selected.at(order.at(i));
+
+        const FileInformation limit{std::filesystem::path(), current.second + left + 1};
+        auto it = candidates.lower_bound(limit);
+        if(it == candidates.begin()) continue;
+        --it;
+
+        if((*it).second <= current.second) continue;
+
+        left -= (*it).second - current.second;
+        auto exchanged = std::move(current);
+        current = *it;
+        candidates.erase(it);
+        candidates.insert(std::move(exchanged));
+        improved = true;
+      }
+    }
+  }
+
+  std::move(candidates.begin(), candidates.end(), std::back_inserter(rejectedDirs));
+
+  dirs = std::move(rejectedDirs);
+
+  for(auto &selected: selectedDirs) std::sort(selected.begin(), selected.end(), Utils::lessThan);
 
   return selectedDirs;
 }
 
 //-----------------------------------------------------------------------------
-bool Utils::copyDirectory(const std::filesystem::path &from, const std::filesystem::path &to)
+std::vector<Utils::FileInformation> Utils::getChildDirectories(const std::filesystem::path &directory, const Capacity &capacity, unsigned int threads)
 {
-  const wchar_t SEPARATOR = '/';
+  std::vector<FileInformation> directories;
 
-  std::error_code error;
+  // measured like the base directories, so the evicted space can be filled with them.
+  const auto tree   = scanDirectoryTree(directory, threads);
+  const auto spaces = copySpaces(tree, capacity, 1);
+  for(std::size_t i = 1; i < tree.size(); ++i)
+  {
+    if(tree.at(i).parent == 0) directories.push_back(spaces.at(i - 1));
+  }
 
-  const auto newFolder = to.wstring() + SEPARATOR + from.filename().wstring();
-  std::filesystem::create_directory(newFolder);
+  return directories;
+}
 
-  const auto files = getPlayableFiles(from);
+//-----------------------------------------------------------------------------
+Utils::SyncSelection Utils::getSyncDirectories(std::vector<FileInformation> &dirs, std::vector<FileInformation> existing,
+                                               const unsigned long long size, const double keepFraction)
+{
+  SyncSelection selection;
 
-  for(auto file: files)
-  {
-    auto fullPath = newFolder + SEPARATOR + file.first.filename().wstring();
-    std::filesystem::copy_file(file.first, fullPath, error);
+  auto addOp = [](const unsigned long long &s, const FileInformation &f) { return s + f.second; };
+  const auto existingSize = std::accumulate(existing.cbegin(), existing.cend(), 0ULL, addOp);
+  const auto keepSize     = std::min<unsigned long long>(size, std::clamp(keepFraction, 0., 1.) * existingSize);
 
-    if (error.value() != 0)
-    {
-      return false;
-    }
+  // the directories are copied by name, so the ones already in the destination can't be selected again.
+  std::set<std::filesystem::path> names;
+  for(const auto &dir: existing) names.insert(dir.first.filename());
+
+  auto isInDestination = [&names](const FileInformation &f) { return names.find(f.first.filename()) != names.cend(); };
+  dirs.erase(std::remove_if(dirs.begin(), dirs.end(), isInDestination), dirs.end());
+
+  if(keepSize >= existingSize)
+  {
+    selection.keep = std::move(existing);
+  }
+  else if(keepSize > 0)
+  {
+    selection.keep  = getCopyDirectories(existing, keepSize);
+    selection.evict = std::move(existing);
+  }
+  else
+  {
+    selection.evict = std::move(existing);
   }
 
-  return true;
+  // only the freed space is selected again, the copied bytes depend on the change and not on the size.
+  const auto keptSize = std::accumulate(selection.keep.cbegin(), selection.keep.cend(), 0ULL, addOp);
+  if(keptSize < size) selection.copy = getCopyDirectories(dirs, size - keptSize);
+
+  return selection;
 }
 
 //-----------------------------------------------------------------------------
@@ -199,6 +867,42 @@ bool Utils::lessThan(const FileInformation &lhs, const FileInformation &rhs)
   return lhs.first < rhs.first;
 }
 
+//-----------------------------------------------------------------------------
+bool Utils::prepareFile(const std::filesystem::path &path, const unsigned long long bytes)
+{
+  std::error_code error;
+  if(!std::filesystem::is_regular_file(path, error)) return false;
+
+  const auto size = std::filesystem::file_size(path, error);
+  if(error || size == 0) return false;
+
+  const auto length = std::min<unsigned long long>(size, bytes);
+  char buffer[4096];
+
+#ifdef __linux__
+  const int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+  if(fd < 0) return false;
+
+  // the kernel reads ahead in the background, the first block is read now to wake up the disk.
+  ::posix_fadvise(fd, 0, static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+  const auto result = ::read(fd, buffer, sizeof(buffer));
+  ::close(fd);
+
+  return result > 0;
+#else
+  std::ifstream file(path, std::ios::binary);
+
+  unsigned long long read = 0;
+  while(file && read < length)
+  {
+    file.read(buffer, sizeof(buffer));
+    read += file.gcount();
+  }
+
+  return read > 0;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 bool Utils::checkIfValidMusicPlayerLocation(const QString &location)
 {
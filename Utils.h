@@ -25,9 +25,38 @@
 
 // C++
 #include <filesystem>
+#include <atomic>
+#include <functional>
+#include <vector>
 
 namespace Utils
 {
+  /** \enum MediaKind
+   * \brief Kinds of playable files.
+   *
+   */
+  enum class MediaKind: char
+  {
+    None = 0, /** not a playable file. */
+    Audio,    /** audio file.          */
+    Video,    /** video file.          */
+    Playlist  /** playlist file.       */
+  };
+
+  /** \brief Returns the media kind of the given path only by its extension, case insensitive.
+   * Doesn't access the disk nor allocates memory.
+   * \param[in] path File path.
+   *
+   */
+  MediaKind mediaKindFromExtension(const std::filesystem::path &path);
+
+  /** \brief Returns the media kind of the given entry. Uses the file type cached by the directory
+   * iterator, so the disk is only accessed for symbolic links.
+   * \param[in] entry Directory entry.
+   *
+   */
+  MediaKind mediaKind(const std::filesystem::directory_entry &entry);
+
   /** \brief Returns true if the given path is an audio file.
    * \param[in] path Absolute file path.
    *
@@ -56,32 +85,190 @@ namespace Utils
    */
   bool lessThan(const FileInformation &lhs, const FileInformation &rhs);
 
+  /** \struct DirectoryInformation
+   * \brief Contains a directory and the playable files directly inside it.
+   *
+   */
+  struct DirectoryInformation
+  {
+      std::filesystem::path        path;       /** absolute directory path.                                 */
+      std::vector<FileInformation> files;      /** playable files of the directory, not recursive.          */
+      std::size_t                  parent = 0; /** position of the parent directory in the list.            */
+  };
+
+  /** \brief Returns the given directory path in normal form and without a trailing separator, except
+   * for a root directory, so its components are a prefix of the components of its sub-directories.
+   * \param[in] directory Directory path.
+   *
+   */
+  std::filesystem::path normalizedDirectory(const std::filesystem::path &directory);
+
+  /** \brief Computes the parent of every directory of the given list in a single pass. The list must
+   * be sorted by path with the base directory first. The sizes are computed by copySpaces().
+   * \param[in] directories List of directories.
+   *
+   */
+  void linkDirectoryTree(std::vector<DirectoryInformation> &directories);
+
+  /** \brief Returns the given directory and all its sub-directories with their playable files
+   * in a single walk of the tree. The list is sorted by path, so every directory comes before
+   * its sub-directories and the first one is always the given directory.
+   * \param[in] directory Absolute path of the directory to scan.
+   * \param[in] threads Number of scanning threads, 0 to use one per core and 1 to scan serially.
+   * \param[in] abort Optional flag to stop the scan, returns an empty list if set.
+   *
+   */
+  std::vector<DirectoryInformation> scanDirectoryTree(const std::filesystem::path &directory, unsigned int threads = 1, const std::atomic<bool> *abort = nullptr);
+
   /** \brief Returns a list of playable files in the given directory.
    * \param[in] directory Absolute path of directory to search for playable files.
+   * \param[in] threads Number of scanning threads, 0 to use one per core and 1 to scan serially.
    *
    */
-  std::vector<FileInformation> getPlayableFiles(const std::filesystem::path &directory);
+  std::vector<FileInformation> getPlayableFiles(const std::filesystem::path &directory, unsigned int threads = 1);
 
-  /** \brief Returns a list of directories of the given base directory.
+  /** \struct Capacity
+   * \brief Space model of a destination file system, used to plan copies that fit before copying.
+   *
+   */
+  struct Capacity
+  {
+      unsigned long long blockSize = 4096; /** allocation unit of the file system in bytes. */
+      unsigned long long available = 0;    /** bytes available to unprivileged users.        */
+
+      /** \brief Returns the space taken by a file of the given size, rounded up to whole blocks.
+       * \param[in] size File size in bytes.
+       *
+       */
+      unsigned long long fileSpace(const unsigned long long size) const
+      { return ((size + blockSize - 1) / blockSize) * blockSize; }
+
+      /** \brief Returns the space taken by the copy of a directory besides its files: the entries of
+       * the destination folder, its verification manifest and its copy journal line.
+       * \param[in] files Number of files of the directory.
+       * \param[in] namesLength Sum of the lengths of the file names.
+       * \param[in] pathLength Length of the source directory path.
+       *
+       */
+      unsigned long long directorySpace(const unsigned long long files, const unsigned long long namesLength,
+                                        const unsigned long long pathLength) const;
+  };
+
+  /** \brief Returns the capacity of the file system of the given path. Returns true on success and false
+   * otherwise.
+   * \param[in] path Path of a directory of the file system.
+   * \param[out] capacity File system block size and available space.
+   *
+   */
+  bool getCapacity(const std::filesystem::path &path, Capacity &capacity);
+
+  /** \brief Returns the directories of the given tree, from the given position, with the space their copies
+   * would take in a destination with the given capacity. See getSubdirectories().
+   * \param[in] tree Directories as returned by scanDirectoryTree().
+   * \param[in] capacity Destination capacity.
+   * \param[in] first Position of the first returned directory.
+   *
+   */
+  std::vector<FileInformation> copySpaces(const std::vector<DirectoryInformation> &tree, const Capacity &capacity, const std::size_t first);
+
+  /** \brief Returns a list of directories of the given base directory with the space their copies would
+   * take in a destination with the given capacity: the playable files of their sub-trees rounded up to
+   * whole blocks plus the overhead of the copied directory.
+   * \param[in] directory Absolute path of directory to search for sub-directories.
+   * \param[in] capacity Destination capacity.
+   * \param[in] threads Number of scanning threads, 0 to use one per core and 1 to scan serially.
+   *
+   */
+  std::vector<FileInformation> getSubdirectories(const std::filesystem::path &directory, const Capacity &capacity, unsigned int threads = 1);
+
+  /** Receives a batch of sized directories, returns false to stop the scan. */
+  using SubdirectoriesCallback = std::function<bool(std::vector<FileInformation> &&)>;
+
+  /** \brief Scans the sub-directories of the given base directory one immediate sub-directory tree at a
+   * time, in random order, and passes the directories of every tree to the callback, sized as in the
+   * capacity version of getSubdirectories() and shuffled, as soon as the tree has been scanned. Returns
+   * true if the whole base directory was scanned and false if stopped.
+   * \param[in] directory Absolute path of the base directory.
+   * \param[in] capacity Destination capacity.
+   * \param[in] callback Receives every batch of directories.
+   * \param[in] threads Number of scanning threads, 0 to use one per core and 1 to scan serially.
+   * \param[in] abort Optional flag to stop the scan.
+   *
+   */
+  bool streamSubdirectories(const std::filesystem::path &directory, const Capacity &capacity, const SubdirectoriesCallback &callback,
+                            unsigned int threads = 1, const std::atomic<bool> *abort = nullptr);
+
+  /** \brief Returns a random sub-directory of the given directory, or an empty path if it has none,
+   * choosing uniformly with reservoir sampling in a single pass without storing the sub-directories.
    * \param[in] directory Absolute path of directory to search for sub-directories.
-   * \param[in] readSize True to read the sizes of the directories and false otherwise.
+   * \param[out] count Number of sub-directories found.
    *
    */
-  std::vector<FileInformation> getSubdirectories(const std::filesystem::path &directory, bool readSize = false);
+  std::filesystem::path getRandomSubdirectory(const std::filesystem::path &directory, std::size_t &count);
 
-  /** \brief Returns a random list of directories adjusted to the given size limit.
-   * \param[in] dirs List of available directories.
+  /** \brief Returns a random list of directories adjusted to the given size limit. Directories are
+   * drawn at random while they fit, then selected directories are exchanged with bigger unselected ones
+   * until the selection is within the tolerance of the limit or the exchanges are exhausted.
+   * \param[inout] dirs List of available directories, on return contains the directories not selected.
    * \param[in] size Size limit in bytes.
+   * \param[in] tolerance Fraction of the size limit that can be left unfilled.
+   * \param[in] iterations Maximum number of exchanges to try to fill the size limit.
    *
    */
-  std::vector<FileInformation> getCopyDirectories(std::vector<FileInformation> &dirs, const unsigned long long size);
+  std::vector<FileInformation> getCopyDirectories(std::vector<FileInformation> &dirs, const unsigned long long size,
+                                                  const double tolerance = 0.001, const unsigned int iterations = 100000);
 
-  /** \brief Copies the playable files of the given directory to the destination one.
-   * \param[in] from Origin directory.
-   * \param[in] to Destination directory.
+  /** \brief Returns random lists of directories, without duplicates, adjusted to the given size limits. Directories
+   * are drawn at random and put in the list with the least remaining space where they fit (best fit), then the
+   * selected directories of every list are exchanged with bigger unselected ones as in the single limit version.
+   * \param[inout] dirs List of available directories, on return contains the directories not selected.
+   * \param[in] sizes Size limits in bytes, one per returned list.
+   * \param[in] tolerance Fraction of every size limit that can be left unfilled.
+   * \param[in] iterations Maximum number of exchanges to try to fill every size limit.
+   *
+   */
+  std::vector<std::vector<FileInformation>> getCopyDirectories(std::vector<FileInformation> &dirs, const std::vector<unsigned long long> &sizes,
+                                                               const double tolerance = 0.001, const unsigned int iterations = 100000);
+
+  /** \struct SyncSelection
+   * \brief Changes to refresh the contents of a destination directory.
+   *
+   */
+  struct SyncSelection
+  {
+      std::vector<FileInformation> keep;  /** destination directories to keep.    */
+      std::vector<FileInformation> evict; /** destination directories to remove.  */
+      std::vector<FileInformation> copy;  /** base directories to copy.           */
+  };
+
+  /** \brief Returns the immediate sub-directories of the given directory with the space their playable
+   * files take in a destination with the given capacity, measured like Utils::getSubdirectories().
+   * \param[in] directory Absolute directory path.
+   * \param[in] capacity Destination capacity.
+   * \param[in] threads Number of scanning threads, 0 to use one per core and 1 to scan serially.
+   *
+   */
+  std::vector<FileInformation> getChildDirectories(const std::filesystem::path &directory, const Capacity &capacity, unsigned int threads = 1);
+
+  /** \brief Selects the changes to refresh a destination with the given size limit. A random part of
+   * the existing directories, as close as possible to the keep fraction of their size, is kept and the
+   * rest evicted. The space up to the size limit is filled with base directories not in the destination.
+   * \param[inout] dirs List of available base directories, on return contains the directories not selected.
+   * \param[in] existing Directories in the destination.
+   * \param[in] size Size limit in bytes of the destination contents.
+   * \param[in] keepFraction Fraction in [0,1] of the existing contents to keep.
+   *
+   */
+  SyncSelection getSyncDirectories(std::vector<FileInformation> &dirs, std::vector<FileInformation> existing,
+                                   const unsigned long long size, const double keepFraction);
+
+  /** \brief Checks that the given file can be read and brings its beginning to the page cache, so casting
+   * it doesn't wait for the disk. Returns true if the file can be played and false otherwise.
+   * \param[in] path Absolute file path.
+   * \param[in] bytes Number of bytes from the start of the file to read ahead.
    *
    */
-  bool copyDirectory(const std::filesystem::path &from, const std::filesystem::path &to);
+  bool prepareFile(const std::filesystem::path &path, const unsigned long long bytes = 8*1024*1024);
 
   /** \brief Helper method to check if music player location is valid.
    * \param[in] location WinAmp location on disk.
@@ -0,0 +1,153 @@
+/*
+ File: XXHash64.cpp
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <XXHash64.h>
+
+// C++
+#include <cstring>
+
+namespace
+{
+  constexpr std::uint64_t PRIME1 = 11400714785074694791ULL;
+  constexpr std::uint64_t PRIME2 = 14029467366897019727ULL;
+  constexpr std::uint64_t PRIME3 =  1609587929392839161ULL;
+  constexpr std::uint64_t PRIME4 =  9650029242287828579ULL;
+  constexpr std::uint64_t PRIME5 =  2870177450012600261ULL;
+
+  inline std::uint64_t rotateLeft(const std::uint64_t value, const int bits)
+  { return (value << bits) | (value >> (64 - bits)); }
+
+  // the hash is defined on little endian values, like the platforms the application runs on.
+  inline std::uint64_t read64(const unsigned char *data)
+  { std::uint64_t value; std::memcpy(&value, data, sizeof(value)); return value; }
+
+  inline std::uint32_t read32(const unsigned char *data)
+  { std::uint32_t value; std::memcpy(&value, data, sizeof(value)); return value; }
+
+  inline std::uint64_t hashRound(std::uint64_t accumulator, const std::uint64_t input)
+  { return rotateLeft(accumulator + input * PRIME2, 31) * PRIME1; }
+
+  inline std::uint64_t mergeRound(std::uint64_t accumulator, const std::uint64_t value)
+  { return (accumulator ^ hashRound(0, value)) * PRIME1 + PRIME4; }
+
+  /** \brief Processes a 32 bytes stripe.
+   * \param[in] accumulators Stripe accumulators.
+   * \param[in] data Stripe data.
+   *
+   */
+  inline void processStripe(std::uint64_t *accumulators, const unsigned char *data)
+  {
+    accumulators[0] = hashRound(accumulators[0], read64(data));
+    accumulators[1] = hashRound(accumulators[1], read64(data + 8));
+    accumulators[2] = hashRound(accumulators[2], read64(data + 16));
+    accumulators[3] = hashRound(accumulators[3], read64(data + 24));
+  }
+}
+
+//-----------------------------------------------------------------------------
+XXHash64::XXHash64(const std::uint64_t seed)
+: m_length{0}
+, m_seed{seed}
+, m_bufferSize{0}
+{
+  m_accumulators[0] = seed + PRIME1 + PRIME2;
+  m_accumulators[1] = seed + PRIME2;
+  m_accumulators[2] = seed;
+  m_accumulators[3] = seed - PRIME1;
+}
+
+//-----------------------------------------------------------------------------
+void XXHash64::update(const void *data, std::size_t length)
+{
+  auto input = static_cast<const unsigned char *>(data);
+  m_length += length;
+
+  if(m_bufferSize + length < sizeof(m_buffer))
+  {
+    std::memcpy(m_buffer + m_bufferSize, input, length);
+    m_bufferSize += length;
+    return;
+  }
+
+  if(m_bufferSize > 0)
+  {
+    const auto fill = sizeof(m_buffer) - m_bufferSize;
+    std::memcpy(m_buffer + m_bufferSize, input, fill);
+    processStripe(m_accumulators, m_buffer);
+    input  += fill;
+    length -= fill;
+    m_bufferSize = 0;
+  }
+
+  for(; length >= sizeof(m_buffer); input += sizeof(m_buffer), length -= sizeof(m_buffer))
+  {
+    processStripe(m_accumulators, input);
+  }
+
+  std::memcpy(m_buffer, input, length);
+  m_bufferSize = length;
+}
+
+//-----------------------------------------------------------------------------
+std::uint64_t XXHash64::digest() const
+{
+  std::uint64_t hash;
+
+  if(m_length >= sizeof(m_buffer))
+  {
+    hash = rotateLeft(m_accumulators[0], 1) + rotateLeft(m_accumulators[1], 7) +
+           rotateLeft(m_accumulators[2], 12) + rotateLeft(m_accumulators[3], 18);
+
+    for(const auto accumulator: m_accumulators) hash = mergeRound(hash, accumulator);
+  }
+  else
+  {
+    hash = m_seed + PRIME5;
+  }
+
+  hash += m_length;
+
+  const unsigned char *data = m_buffer;
+  const unsigned char *end  = m_buffer + m_bufferSize;
+
+  for(; data + 8 <= end; data += 8)
+  {
+    hash = rotateLeft(hash ^ hashRound(0, read64(data)), 27) * PRIME1 + PRIME4;
+  }
+
+  if(data + 4 <= end)
+  {
+    hash = rotateLeft(hash ^ (read32(data) * PRIME1), 23) * PRIME2 + PRIME3;
+    data += 4;
+  }
+
+  for(; data < end; ++data)
+  {
+    hash = rotateLeft(hash ^ (*data * PRIME5), 11) * PRIME1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
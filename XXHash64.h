@@ -0,0 +1,61 @@
+/*
+ File: XXHash64.h
+ Created on: 16/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XXHASH64_H_
+#define XXHASH64_H_
+
+// C++
+#include <cstddef>
+#include <cstdint>
+
+/** \class XXHash64
+ * \brief Streaming implementation of the XXH64 non-cryptographic hash. The data can be given in
+ * blocks of any size, the result is the same as hashing it at once.
+ *
+ */
+class XXHash64
+{
+  public:
+    /** \brief XXHash64 class constructor.
+     * \param[in] seed Hash seed.
+     *
+     */
+    explicit XXHash64(const std::uint64_t seed = 0);
+
+    /** \brief Adds the given data to the hash.
+     * \param[in] data Data pointer.
+     * \param[in] length Data length in bytes.
+     *
+     */
+    void update(const void *data, std::size_t length);
+
+    /** \brief Returns the hash of the data added until now.
+     *
+     */
+    std::uint64_t digest() const;
+
+  private:
+    std::uint64_t m_accumulators[4]; /** stripe accumulators.                    */
+    std::uint64_t m_length;          /** total length of the data.               */
+    std::uint64_t m_seed;            /** hash seed.                              */
+    unsigned char m_buffer[32];      /** data not yet processed, less than a stripe. */
+    std::size_t   m_bufferSize;      /** bytes in m_buffer.                      */
+};
+
+#endif // XXHASH64_H_